@@ -1,8 +1,25 @@
 /* 
  *	Powershell command to run this:
- * 		g++ Clickerino.cpp -o a.exe -std=c++11 -lgdiplus -lgdi32 -lopengl32 -lglu32; .\a.exe
+ * 		g++ -O2 Clickerino.cpp -o a.exe -std=c++11 -lgdiplus -lgdi32 -lopengl32 -lglu32; .\a.exe
  *  (Linux/Ubuntu) terminal command to run this:
- * 		g++ -o a.exe Clickerino.cpp -lX11 -lGL -lpthread -lpng; vblank_mode=0 ./a.exe
+ * 		g++ -O2 -o a.exe Clickerino.cpp -lX11 -lXext -lGL -lpthread -lpng; ./a.exe
+ *  options:
+ * 		--seed <number>		seed for block spawning, the seed of every run is printed at start
+ * 		--record <file>		write input of every game to file (last game wins)
+ * 		--replay <file>		play recorded game back one tick per frame and print frame times
+ * 		--fps <number>		frame rate limit (default 60)
+ * 		--idle-fps <number>	frame rate limit while nothing on screen changes (default 15)
+ * 		--uncapped			no frame rate limit, default for --replay (may also need vblank_mode=0)
+ * 		--pipeline <2|3>	update, render and present frames on separate threads with 2 or 3 back buffers
+ * 		--backend <name>	gl (default), xshm (X11 shared memory, no OpenGL) or headless (no window, needs --replay)
+ * 		--frames <file>		with headless, write every presented frame to file as raw 500x500 RGBA
+ * 		--profile			count allocations, show them per frame in an overlay and add them to the replay output
+ * 		--depth-prepass		draw depth of all objects before their colors, so that every pixel is colored once
+ * 		--raster <name>		rasterizer kernel: scalar, sse2 or avx2, by default the best one the cpu supports
+ * 		--jobs <number>		worker threads for loading and drawing, 0 does everything on one thread (default one per extra core)
+ * 		--render-budget <ms>	draw 3d at the resolution that takes about this long and stretch it to the window, the hud stays sharp
+ * 		--upscale <name>	how --render-budget stretches: nearest (default) or bilinear
+ * 		--indexed			draw 3d as 8 bit palette indices, expanded to colors once per pixel at the end
  * 
  *	ToDo:
  *		convert pairs to tuples
@@ -21,8 +38,23 @@
 #include <string>
 #include <fstream>
 #include <map>
+#include <cstring>
+#include <cassert>
 
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <type_traits>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 
 #include <ctime>
 
@@ -30,6 +62,285 @@ using namespace std;
 
 
 
+/*
+ * Lib: Allocations
+ */
+
+// allocation totals per tag, the difference of two snapshots gives the allocations made in between
+class AllocationSnapshot {
+	public:
+		static const int maxTags = 8;
+
+		uint64_t counts[maxTags];
+		uint64_t bytes[maxTags];
+
+		AllocationSnapshot() {
+			for (int tag = 0; tag < maxTags; tag++) {
+				counts[tag] = 0;
+				bytes[tag] = 0;
+			}
+		}
+
+		AllocationSnapshot since(const AllocationSnapshot& earlier) const {
+			AllocationSnapshot result;
+
+			for (int tag = 0; tag < maxTags; tag++) {
+				result.counts[tag] = counts[tag]-earlier.counts[tag];
+				result.bytes[tag] = bytes[tag]-earlier.bytes[tag];
+			}
+
+			return result;
+		}
+
+		uint64_t totalCount() const {
+			uint64_t total = 0;
+
+			for (int tag = 0; tag < maxTags; tag++) {
+				total += counts[tag];
+			}
+
+			return total;
+		}
+
+		uint64_t totalBytes() const {
+			uint64_t total = 0;
+
+			for (int tag = 0; tag < maxTags; tag++) {
+				total += bytes[tag];
+			}
+
+			return total;
+		}
+};
+
+/*
+ * while enabled, operator new counts every allocation of the program into the tag active on the allocating thread,
+ * tags are small numbers given out by the application, which may also name them, tag 0 is everything untagged
+ */
+class Allocations {
+	public:
+		static atomic<bool> enabled;
+		static atomic<uint64_t> counts[AllocationSnapshot::maxTags];
+		static atomic<uint64_t> bytes[AllocationSnapshot::maxTags];
+		static const char* names[AllocationSnapshot::maxTags];
+		static thread_local int activeTag;
+
+		static void record(size_t size) {
+			if (enabled.load(memory_order_relaxed)) {
+				counts[activeTag].fetch_add(1, memory_order_relaxed);
+				bytes[activeTag].fetch_add(size, memory_order_relaxed);
+			}
+		}
+
+		static AllocationSnapshot snapshot() {
+			AllocationSnapshot result;
+
+			for (int tag = 0; tag < AllocationSnapshot::maxTags; tag++) {
+				result.counts[tag] = counts[tag].load(memory_order_relaxed);
+				result.bytes[tag] = bytes[tag].load(memory_order_relaxed);
+			}
+
+			return result;
+		}
+};
+
+atomic<bool> Allocations::enabled(false);
+atomic<uint64_t> Allocations::counts[AllocationSnapshot::maxTags];
+atomic<uint64_t> Allocations::bytes[AllocationSnapshot::maxTags];
+const char* Allocations::names[AllocationSnapshot::maxTags] = {"other"};
+thread_local int Allocations::activeTag = 0;
+
+// allocations of this thread go to tag until the scope ends
+class AllocationScope {
+	public:
+		int previousTag;
+
+		AllocationScope(int tag) {
+			previousTag = Allocations::activeTag;
+			Allocations::activeTag = tag;
+		}
+
+		~AllocationScope() {
+			Allocations::activeTag = previousTag;
+		}
+};
+
+// gcc would inline the deletes into their callers and then take the free for a mismatch with operator new
+#if defined(__GNUC__)
+#define CLICKERINO_NOINLINE __attribute__((noinline))
+#else
+#define CLICKERINO_NOINLINE
+#endif
+
+void* operator new(size_t size) {
+	Allocations::record(size);
+
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == nullptr) {
+		throw bad_alloc();
+	}
+
+	return memory;
+}
+
+CLICKERINO_NOINLINE void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+// the other forms do the same as the two above, so no allocation can bypass the count
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+CLICKERINO_NOINLINE void operator delete[](void* memory) noexcept {
+	free(memory);
+}
+
+CLICKERINO_NOINLINE void operator delete(void* memory, size_t) noexcept {
+	free(memory);
+}
+
+CLICKERINO_NOINLINE void operator delete[](void* memory, size_t) noexcept {
+	free(memory);
+}
+
+
+
+/*
+ * Lib: FrameArena
+ */
+
+/*
+ * bump allocator for data that lives for one frame, everything is given back at once by reset,
+ * what does not fit goes into extra blocks and the next reset grows the arena so that it fits from then on
+ */
+class FrameArena {
+	public:
+		static const size_t alignment = 16;
+
+		uint8_t* memory;
+		size_t capacity;
+		size_t used;
+		size_t overflowBytes;
+		vector<void*> overflow;
+
+		FrameArena(size_t capacity = 1 << 16): memory(nullptr), capacity(capacity), used(0), overflowBytes(0) {}
+
+		// copies start empty, memory of an arena is never shared
+		FrameArena(const FrameArena& other): FrameArena(other.capacity) {}
+
+		FrameArena& operator=(const FrameArena& other) {
+			if (this != &other) {
+				release();
+				capacity = other.capacity;
+			}
+
+			return *this;
+		}
+
+		~FrameArena() {
+			release();
+		}
+
+		void* allocate(size_t size) {
+			size = (size+alignment-1) & ~(alignment-1);
+
+			if (memory == nullptr) {
+				memory = (uint8_t*) ::operator new(capacity);
+			}
+
+			if (used+size > capacity) {
+				void* block = ::operator new(size);
+				overflow.push_back(block);
+				overflowBytes += size;
+
+				return block;
+			}
+
+			void* result = memory+used;
+			used += size;
+
+			return result;
+		}
+
+		template<class T> T* allocate(size_t count) {
+			static_assert(is_trivially_destructible<T>::value, "arena memory is reused without running destructors");
+
+			T* result = (T*) allocate(count*sizeof(T));
+			for (size_t index = 0; index < count; index++) {
+				new (result+index) T;
+			}
+
+			return result;
+		}
+
+		void reset() {
+			if (overflowBytes > 0) {
+				size_t needed = used+overflowBytes;
+
+				release();
+				while (capacity < needed) {
+					capacity *= 2;
+				}
+			}
+
+			used = 0;
+		}
+
+		void release() {
+			for (vector<void*>::iterator block = overflow.begin(); block != overflow.end(); block++) {
+				::operator delete(*block);
+			}
+			overflow.clear();
+			overflowBytes = 0;
+
+			::operator delete(memory);
+			memory = nullptr;
+			used = 0;
+		}
+};
+
+// fixed size array in a frame arena, valid until the arena is reset
+template<class T> class ArenaArray {
+	public:
+		T* data;
+		size_t count;
+
+		ArenaArray(): data(nullptr), count(0) {}
+
+		ArenaArray(FrameArena& arena, size_t count): data(arena.allocate<T>(count)), count(count) {}
+
+		size_t size() const {
+			return count;
+		}
+
+		T& operator[](size_t index) {
+			return data[index];
+		}
+
+		const T& operator[](size_t index) const {
+			return data[index];
+		}
+
+		T* begin() {
+			return data;
+		}
+
+		T* end() {
+			return data+count;
+		}
+
+		const T* begin() const {
+			return data;
+		}
+
+		const T* end() const {
+			return data+count;
+		}
+};
+
+
+
 /*
  * Lib: 3dEngine
  */
@@ -69,6 +380,14 @@ class vector3d {
 		vector3d() {}
 
 		vector3d(float x, float y, float z): x(x), y(y), z(z) {}
+
+		bool operator==(const vector3d& other) const {
+			return x == other.x && y == other.y && z == other.z;
+		}
+
+		bool operator!=(const vector3d& other) const {
+			return !(*this == other);
+		}
 };
 
 class vector2d {
@@ -81,14 +400,51 @@ class vector2d {
 		vector2d(float x, float y): x(x), y(y) {}
 };
 
+/*
+ * every material color of the program, so that a pixel can be stored as its index,
+ * index 0 is no color, colors that do not fit anymore get it and set overflowed
+ */
+class Palette {
+	public:
+		static olc::Pixel colors[256];
+		static int count;
+		static atomic<bool> overflowed;
+		static mutex lock;
+
+		// the same color always gets the same index, can be called from several loading threads
+		static uint8_t indexOf(olc::Pixel color) {
+			lock_guard<mutex> guard(lock);
+
+			for (int index = 1; index < count; index++) {
+				if (colors[index].n == color.n) {
+					return index;
+				}
+			}
+
+			if (count == 256) {
+				overflowed = true;
+				return 0;
+			}
+
+			colors[count] = color;
+			return count++;
+		}
+};
+
+olc::Pixel Palette::colors[256];
+int Palette::count = 1;
+atomic<bool> Palette::overflowed(false);
+mutex Palette::lock;
+
 class Material {
 	public:
 		olc::Pixel color;
 		string name;
+		uint8_t paletteIndex;
 
-		Material() {}
+		Material(): paletteIndex(0) {}
 
-		Material(olc::Pixel color, string name): color(color), name(name) {}
+		Material(olc::Pixel color, string name): color(color), name(name), paletteIndex(Palette::indexOf(color)) {}
 
 		static map<string, Material> loadFromFile(string folderPath) {
 			map<string, Material> materials;
@@ -134,32 +490,62 @@ class Material {
 	}
 };
 
-class Object {
+// points and triangles as loaded from disk, shared by every copy of an object and never changed
+class Mesh {
 	public:
 		vector<vector3d> points;
 		vector<tuple<tuple<int, int, int>, Material>> triangles;
 
+		Mesh() {}
+
+		Mesh(vector<vector3d> points, vector<tuple<tuple<int, int, int>, Material>> triangles): points(points), triangles(triangles) {}
+
+		// of objects that were never loaded, shared so that constructing one allocates nothing
+		static const shared_ptr<const Mesh>& empty() {
+			static const shared_ptr<const Mesh> mesh = make_shared<Mesh>();
+
+			return mesh;
+		}
+};
+
+class Object {
+	public:
+		shared_ptr<const Mesh> mesh;
+
 		vector3d pos;
 		vector3d scale;
 		vector3d rotation;
 
-		Object() {};
+		// points rotated and scaled, and those moved to pos, recalculated by getPoints when the transform changed
+		vector<vector3d> localPoints;
+		vector<vector3d> worldPoints;
+		bool localDirty;
+		bool worldDirty;
+
+		// used instead of localPoints when set, see ObjectCache::getOrientation
+		const vector<vector3d>* sharedLocalPoints;
 
-		Object(vector<vector3d> points, vector<tuple<tuple<int, int, int>, Material>> triangles): points(points), triangles(triangles) {
+		Object(): mesh(Mesh::empty()), localDirty(true), worldDirty(true), sharedLocalPoints(nullptr) {};
+
+		Object(vector<vector3d> points, vector<tuple<tuple<int, int, int>, Material>> triangles): mesh(make_shared<Mesh>(points, triangles)) {
 			pos = {0, 0, 0};
 			rotation = {0, 0, 0};
 			scale = {1, 1, 1};
+
+			localDirty = true;
+			worldDirty = true;
+			sharedLocalPoints = nullptr;
 		}
 
 		static Object copy(Object object) {
 			vector<vector3d> points;
 			vector<tuple<tuple<int, int, int>, Material>> triangles;
 
-			for (vector<vector3d>::iterator point = object.points.begin(); point != object.points.end(); point++) {
+			for (vector<vector3d>::const_iterator point = object.mesh->points.begin(); point != object.mesh->points.end(); point++) {
 				points.push_back(*point);
 			}
 
-			for (vector<tuple<tuple<int, int, int>, Material>>::iterator triangle = object.triangles.begin(); triangle != object.triangles.end(); triangle++) {
+			for (vector<tuple<tuple<int, int, int>, Material>>::const_iterator triangle = object.mesh->triangles.begin(); triangle != object.mesh->triangles.end(); triangle++) {
 				triangles.push_back(*triangle);
 			}
 
@@ -219,348 +605,1244 @@ class Object {
 		}
 
 		void setPos(vector3d newPos) {
-			pos = newPos;
+			if (newPos != pos) {
+				pos = newPos;
+				worldDirty = true;
+			}
 		}
 
 		void setRotation(vector3d newRotation) {
-			rotation = newRotation;
+			if (newRotation != rotation) {
+				rotation = newRotation;
+				localDirty = true;
+				sharedLocalPoints = nullptr;
+			}
 		}
 
 		void setScale(vector3d newScale) {
+			if (newScale != scale) {
+				scale = newScale;
+				localDirty = true;
+				sharedLocalPoints = nullptr;
+			}
+		}
+
+		// rotation and scale whose points were already calculated, they are used as they are
+		void setOrientation(vector3d newRotation, vector3d newScale, const vector<vector3d>* points) {
+			rotation = newRotation;
 			scale = newScale;
+			sharedLocalPoints = points;
+
+			localDirty = false;
+			worldDirty = true;
+		}
+
+		// world space points, only moved when just pos changed and not touched when nothing changed
+		const vector<vector3d>& getPoints() {
+			if (localDirty) {
+				updateLocalPoints();
+				localDirty = false;
+				worldDirty = true;
+			}
+
+			if (worldDirty) {
+				const vector<vector3d>& local = sharedLocalPoints != nullptr ? *sharedLocalPoints : localPoints;
+				worldPoints.resize(local.size());
+
+				for (size_t index = 0; index < local.size(); index++) {
+					worldPoints[index] = {local[index].x+pos.x, local[index].y+pos.y, local[index].z+pos.z};
+				}
+
+				worldDirty = false;
+			}
+
+			return worldPoints;
 		}
 
-		vector<vector3d> getPoints() {
-			vector<vector3d> pointsx;
+		void updateLocalPoints() {
+			const vector<vector3d>& points = mesh->points;
+			localPoints.resize(points.size());
+
+			float cosX = cos(rotation.x);
+			float sinX = sin(rotation.x);
+			float cosY = cos(rotation.y);
+			float sinY = sin(rotation.y);
+			float cosZ = cos(rotation.z);
+			float sinZ = sin(rotation.z);
 
-			for (vector<vector3d>::iterator point = points.begin(); point != points.end(); point++) {
-				float x = point->x;
-				float y = point->y;
-				float z = point->z;
+			for (size_t index = 0; index < points.size(); index++) {
+				float x = points[index].x;
+				float y = points[index].y;
+				float z = points[index].z;
 
-				float cosX = cos(rotation.x);
-				float sinX = sin(rotation.x);
 				y = y*cosX-z*sinX;
 				z = y*sinX+z*cosX;
 
-				float cosY = cos(rotation.y);
-				float sinY = sin(rotation.y);
 				z = z*cosY-x*sinY;
 				x = z*sinY+x*cosY;
 
-				float cosZ = cos(rotation.z);
-				float sinZ = sin(rotation.z);
 				x = x*cosZ-y*sinZ;
 				y = x*sinZ+y*cosZ;
 
-				pointsx.push_back({x*scale.x+pos.x, y*scale.y+pos.y, z*scale.z+pos.z});
+				localPoints[index] = {x*scale.x, y*scale.y, z*scale.z};
+			}
+		}
+};
+
+// objects are parsed from disk once and copied from then on, parsing is far too slow to do while playing
+class ObjectCache {
+	public:
+		map<string, Object> objects;
+		map<string, vector<vector<vector3d>>> orientations;
+		mutex lock;
+
+		// can run on another thread than get, files are parsed without holding the lock
+		void preload(vector<string> folderPaths) {
+			for (vector<string>::iterator folderPath = folderPaths.begin(); folderPath != folderPaths.end(); folderPath++) {
+				if (!contains(*folderPath)) {
+					Object object = Object::loadFromFile(*folderPath);
+
+					lock_guard<mutex> guard(lock);
+					objects.insert(make_pair(*folderPath, object));
+				}
+			}
+		}
+
+		bool contains(string folderPath) {
+			lock_guard<mutex> guard(lock);
+
+			return objects.find(folderPath) != objects.end();
+		}
+
+		// objects that were not preloaded are loaded here, on the calling thread
+		Object get(string folderPath) {
+			{
+				lock_guard<mutex> guard(lock);
+
+				map<string, Object>::iterator object = objects.find(folderPath);
+				if (object != objects.end()) {
+					return object->second;
+				}
+			}
+
+			preload({folderPath});
+
+			return get(folderPath);
+		}
+
+		// points of an object rotated by each of rotations and scaled, for objects that only ever take one of a few orientations
+		void preloadOrientations(string folderPath, const vector<vector3d>& rotations, vector3d scale) {
+			{
+				lock_guard<mutex> guard(lock);
+
+				if (orientations.find(folderPath) != orientations.end()) {
+					return;
+				}
+			}
+
+			Object object = get(folderPath);
+			object.setScale(scale);
+
+			vector<vector<vector3d>> variants;
+			for (vector<vector3d>::const_iterator rotation = rotations.begin(); rotation != rotations.end(); rotation++) {
+				object.setRotation(*rotation);
+				object.updateLocalPoints();
+				variants.push_back(object.localPoints);
+			}
+
+			lock_guard<mutex> guard(lock);
+			orientations.insert(make_pair(folderPath, variants));
+		}
+
+		// shared by every caller and valid as long as the cache, rotations and scale have to be the ones of the preload
+		const vector<vector3d>* getOrientation(string folderPath, const vector<vector3d>& rotations, vector3d scale, int index) {
+			{
+				lock_guard<mutex> guard(lock);
+
+				map<string, vector<vector<vector3d>>>::iterator variants = orientations.find(folderPath);
+				if (variants != orientations.end()) {
+					return &variants->second[index];
+				}
+			}
+
+			preloadOrientations(folderPath, rotations, scale);
+
+			return getOrientation(folderPath, rotations, scale, index);
+		}
+};
+
+/*
+ * an object as the renderer gets it, its mesh is shared and its world points are copied into the arena of the frame,
+ * so the simulation can go on changing the object meanwhile
+ */
+class FrameObject {
+	public:
+		// kept alive by the ObjectCache, which every drawn object comes from
+		const Mesh* mesh;
+		ArenaArray<vector3d> points;
+};
+
+class Camera {
+	public:
+		vector3d center;
+		vector3d direction;
+		vector3d view1;
+		vector3d view2;
+
+		Camera() {}
+
+		Camera(vector3d center, vector3d direction, vector3d view1, vector3d view2): center(center), direction(direction), view1(view1), view2(view2) {}
+};
+
+// division rounding down and up, also for negative numerators
+inline int64_t floorDiv(int64_t numerator, int64_t denominator) {
+	int64_t quotient = numerator/denominator;
+
+	return quotient*denominator > numerator ? quotient-1 : quotient;
+}
+
+inline int64_t ceilDiv(int64_t numerator, int64_t denominator) {
+	return -floorDiv(-numerator, denominator);
+}
+
+// screen coordinate in 28.4 fixed point, far away points are clamped so that edge functions can not overflow
+inline int64_t toFixed(float coordinate) {
+	return (int64_t) lround(max(min(coordinate, 1e6f), -1e6f)*16);
+}
+
+/*
+ * edge of a triangle in 28.4 fixed point, at is positive on the inside of a triangle with positive area,
+ * pixel centers exactly on an edge belong to the triangle only for top and left edges,
+ * so that triangles sharing an edge never both cover a pixel
+ */
+class Edge {
+	public:
+		int64_t x0;
+		int64_t y0;
+		int64_t dx;
+		int64_t dy;
+		int64_t bias;
+
+		Edge(int64_t x0, int64_t y0, int64_t x1, int64_t y1): x0(x0), y0(y0) {
+			dx = x1-x0;
+			dy = y1-y0;
+
+			bool topLeft = (dy == 0 && dx > 0) || dy < 0;
+			bias = topLeft ? 0 : -1;
+		}
+
+		int64_t at(int64_t x, int64_t y) const {
+			return dx*(y-y0)-dy*(x-x0);
+		}
+
+		// narrows xStart to xEnd to the pixels of row y whose centers are inside, false when none are
+		bool clipRow(int64_t y, int& xStart, int& xEnd) const {
+			// inside where at(x*16+8, y)+bias >= 0, so where constant-dy*16*x >= 0
+			int64_t constant = at(8, y)+bias;
+
+			if (dy == 0) {
+				if (constant < 0) {
+					return false;
+				}
+			} else if (dy < 0) {
+				int64_t first = ceilDiv(-constant, -dy*16);
+				if (first > xStart) {
+					xStart = (int) min(first, (int64_t) xEnd+1);
+				}
+			} else {
+				int64_t last = floorDiv(constant, dy*16);
+				if (last < xEnd) {
+					xEnd = (int) max(last, (int64_t) xStart-1);
+				}
 			}
 
-			return pointsx;
+			return xStart <= xEnd;
 		}
 };
 
-class Camera {
-	public:
-		vector3d center;
-		vector3d direction;
-		vector3d view1;
-		vector3d view2;
+/*
+ * one row of a triangle for the row kernels, weights of the points are base+step*x,
+ * depth is the distance of the interpolated point to center
+ */
+enum RasterPass { DEPTH_AND_COLOR, DEPTH, COLOR };
+
+class RasterRow {
+	public:
+		RasterPass pass;
+		uint32_t number;
+
+		/*
+		 * the edge values of pixel x that weigh points A and B are edgeA-edgeStepA*x and edgeB-edgeStepB*x, exact in 28.4 fixed point,
+		 * narrow when every value inside the triangle fits in 32 bits, which the simd kernels need
+		 */
+		int64_t edgeA;
+		int64_t edgeStepA;
+		int64_t edgeB;
+		int64_t edgeStepB;
+		float invArea;
+		bool narrow;
+		vector3d pointA;
+		vector3d pointB;
+		vector3d pointC;
+		vector3d center;
+
+		float* depthRow;
+		uint32_t* winnersRow;
+		// for the pixels from xStart on
+		uint8_t* spanMask;
+		int xStart;
+
+		bool covered;
+		int overdraw;
+		int savedOverdraw;
+};
+
+// every kernel has to calculate exactly this, so that they all draw the same pixels
+inline void rasterPixelsScalar(RasterRow& row, int xFrom, int xTo) {
+	for (int x = xFrom; x <= xTo; x++) {
+		// the prepass already decided which pixels get this color
+		if (row.pass == COLOR) {
+			if (row.winnersRow[x] == row.number) {
+				row.spanMask[x-row.xStart] = 1;
+				row.covered = true;
+			} else {
+				row.spanMask[x-row.xStart] = 0;
+				row.savedOverdraw++;
+			}
+
+			continue;
+		}
+
+		float weightA = (row.edgeA-row.edgeStepA*x)*row.invArea;
+		float weightB = (row.edgeB-row.edgeStepB*x)*row.invArea;
+		float weightC = 1.0f-weightA-weightB;
+
+		float distanceX = row.center.x-(weightA*row.pointA.x+weightB*row.pointB.x+weightC*row.pointC.x);
+		float distanceY = row.center.y-(weightA*row.pointA.y+weightB*row.pointB.y+weightC*row.pointC.y);
+		float distanceZ = row.center.z-(weightA*row.pointA.z+weightB*row.pointB.z+weightC*row.pointC.z);
+
+		float pDistance = sqrtf(distanceX*distanceX+distanceY*distanceY+distanceZ*distanceZ);
+
+		float depth = row.depthRow[x];
+
+		if (depth > pDistance || depth == -1) {
+			if (row.pass == DEPTH_AND_COLOR && depth != -1) {
+				row.overdraw++;
+			}
+
+			if (row.pass == DEPTH) {
+				row.winnersRow[x] = row.number;
+			}
+
+			row.depthRow[x] = pDistance;
+			row.spanMask[x-row.xStart] = 1;
+			row.covered = true;
+		} else {
+			row.spanMask[x-row.xStart] = 0;
+
+			if (row.pass == DEPTH_AND_COLOR) {
+				row.savedOverdraw++;
+			}
+		}
+	}
+}
+
+inline void storeSpanMask(RasterRow& row, int x, int bits, int lanes) {
+	for (int lane = 0; lane < lanes; lane++) {
+		row.spanMask[x+lane-row.xStart] = (bits >> lane) & 1;
+	}
+}
+
+#ifdef OLC_SSE2
+// 4 pixels at once, the rest of the row goes through the scalar kernel
+inline void rasterPixelsSSE2(RasterRow& row, int xFrom, int xTo) {
+	int x = xFrom;
+
+	if (row.pass == COLOR) {
+		__m128i number = _mm_set1_epi32((int) row.number);
+
+		for (; x+3 <= xTo; x += 4) {
+			__m128i winners = _mm_loadu_si128((__m128i*) (row.winnersRow+x));
+			int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(winners, number)));
+
+			storeSpanMask(row, x, bits, 4);
+			row.covered |= bits != 0;
+			row.savedOverdraw += 4-__builtin_popcount(bits);
+		}
+	} else if (row.narrow) {
+		// lanes 1 to 3 are this much further along the edges, only used on spans of 4 pixels or more, where it fits
+		__m128i lanesA = _mm_set_epi32((int32_t) (row.edgeStepA*3), (int32_t) (row.edgeStepA*2), (int32_t) row.edgeStepA, 0);
+		__m128i lanesB = _mm_set_epi32((int32_t) (row.edgeStepB*3), (int32_t) (row.edgeStepB*2), (int32_t) row.edgeStepB, 0);
+		__m128 invArea = _mm_set1_ps(row.invArea);
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 empty = _mm_set1_ps(-1.0f);
+		__m128i number = _mm_set1_epi32((int) row.number);
+
+		__m128 pointAx = _mm_set1_ps(row.pointA.x);
+		__m128 pointAy = _mm_set1_ps(row.pointA.y);
+		__m128 pointAz = _mm_set1_ps(row.pointA.z);
+		__m128 pointBx = _mm_set1_ps(row.pointB.x);
+		__m128 pointBy = _mm_set1_ps(row.pointB.y);
+		__m128 pointBz = _mm_set1_ps(row.pointB.z);
+		__m128 pointCx = _mm_set1_ps(row.pointC.x);
+		__m128 pointCy = _mm_set1_ps(row.pointC.y);
+		__m128 pointCz = _mm_set1_ps(row.pointC.z);
+		__m128 centerX = _mm_set1_ps(row.center.x);
+		__m128 centerY = _mm_set1_ps(row.center.y);
+		__m128 centerZ = _mm_set1_ps(row.center.z);
+
+		for (; x+3 <= xTo; x += 4) {
+			__m128i edgeA = _mm_sub_epi32(_mm_set1_epi32((int32_t) (row.edgeA-row.edgeStepA*x)), lanesA);
+			__m128i edgeB = _mm_sub_epi32(_mm_set1_epi32((int32_t) (row.edgeB-row.edgeStepB*x)), lanesB);
+
+			__m128 weightA = _mm_mul_ps(_mm_cvtepi32_ps(edgeA), invArea);
+			__m128 weightB = _mm_mul_ps(_mm_cvtepi32_ps(edgeB), invArea);
+			__m128 weightC = _mm_sub_ps(_mm_sub_ps(one, weightA), weightB);
+
+			__m128 distanceX = _mm_sub_ps(centerX, _mm_add_ps(_mm_add_ps(_mm_mul_ps(weightA, pointAx), _mm_mul_ps(weightB, pointBx)), _mm_mul_ps(weightC, pointCx)));
+			__m128 distanceY = _mm_sub_ps(centerY, _mm_add_ps(_mm_add_ps(_mm_mul_ps(weightA, pointAy), _mm_mul_ps(weightB, pointBy)), _mm_mul_ps(weightC, pointCy)));
+			__m128 distanceZ = _mm_sub_ps(centerZ, _mm_add_ps(_mm_add_ps(_mm_mul_ps(weightA, pointAz), _mm_mul_ps(weightB, pointBz)), _mm_mul_ps(weightC, pointCz)));
+
+			__m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(distanceX, distanceX), _mm_mul_ps(distanceY, distanceY)), _mm_mul_ps(distanceZ, distanceZ));
+			__m128 pDistance = _mm_sqrt_ps(squared);
+
+			__m128 depth = _mm_loadu_ps(row.depthRow+x);
+			__m128 wasEmpty = _mm_cmpeq_ps(depth, empty);
+			__m128 passed = _mm_or_ps(_mm_cmpgt_ps(depth, pDistance), wasEmpty);
+			int bits = _mm_movemask_ps(passed);
+
+			if (bits != 0) {
+				_mm_storeu_ps(row.depthRow+x, _mm_or_ps(_mm_and_ps(passed, pDistance), _mm_andnot_ps(passed, depth)));
+
+				if (row.pass == DEPTH) {
+					__m128i winners = _mm_loadu_si128((__m128i*) (row.winnersRow+x));
+					__m128i mask = _mm_castps_si128(passed);
+					_mm_storeu_si128((__m128i*) (row.winnersRow+x), _mm_or_si128(_mm_and_si128(mask, number), _mm_andnot_si128(mask, winners)));
+				}
+			}
+
+			if (row.pass == DEPTH_AND_COLOR) {
+				row.overdraw += __builtin_popcount(bits & ~_mm_movemask_ps(wasEmpty));
+				row.savedOverdraw += 4-__builtin_popcount(bits);
+			}
+
+			storeSpanMask(row, x, bits, 4);
+			row.covered |= bits != 0;
+		}
+	}
+
+	rasterPixelsScalar(row, x, xTo);
+}
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CLICKERINO_AVX2
+
+// 8 pixels at once, only called after cpuid reported avx2
+__attribute__((target("avx2"))) void rasterPixelsAVX2(RasterRow& row, int xFrom, int xTo) {
+	int x = xFrom;
+
+	if (row.pass == COLOR) {
+		__m256i number = _mm256_set1_epi32((int) row.number);
+
+		for (; x+7 <= xTo; x += 8) {
+			__m256i winners = _mm256_loadu_si256((__m256i*) (row.winnersRow+x));
+			int bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(winners, number)));
+
+			storeSpanMask(row, x, bits, 8);
+			row.covered |= bits != 0;
+			row.savedOverdraw += 8-__builtin_popcount(bits);
+		}
+	} else if (row.narrow) {
+		// lanes 1 to 7 are this much further along the edges, only used on spans of 8 pixels or more, where it fits
+		__m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+		__m256i lanesA = _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int32_t) row.edgeStepA));
+		__m256i lanesB = _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int32_t) row.edgeStepB));
+		__m256 invArea = _mm256_set1_ps(row.invArea);
+		__m256 one = _mm256_set1_ps(1.0f);
+		__m256 empty = _mm256_set1_ps(-1.0f);
+		__m256i number = _mm256_set1_epi32((int) row.number);
+
+		__m256 pointAx = _mm256_set1_ps(row.pointA.x);
+		__m256 pointAy = _mm256_set1_ps(row.pointA.y);
+		__m256 pointAz = _mm256_set1_ps(row.pointA.z);
+		__m256 pointBx = _mm256_set1_ps(row.pointB.x);
+		__m256 pointBy = _mm256_set1_ps(row.pointB.y);
+		__m256 pointBz = _mm256_set1_ps(row.pointB.z);
+		__m256 pointCx = _mm256_set1_ps(row.pointC.x);
+		__m256 pointCy = _mm256_set1_ps(row.pointC.y);
+		__m256 pointCz = _mm256_set1_ps(row.pointC.z);
+		__m256 centerX = _mm256_set1_ps(row.center.x);
+		__m256 centerY = _mm256_set1_ps(row.center.y);
+		__m256 centerZ = _mm256_set1_ps(row.center.z);
+
+		for (; x+7 <= xTo; x += 8) {
+			__m256i edgeA = _mm256_sub_epi32(_mm256_set1_epi32((int32_t) (row.edgeA-row.edgeStepA*x)), lanesA);
+			__m256i edgeB = _mm256_sub_epi32(_mm256_set1_epi32((int32_t) (row.edgeB-row.edgeStepB*x)), lanesB);
+
+			__m256 weightA = _mm256_mul_ps(_mm256_cvtepi32_ps(edgeA), invArea);
+			__m256 weightB = _mm256_mul_ps(_mm256_cvtepi32_ps(edgeB), invArea);
+			__m256 weightC = _mm256_sub_ps(_mm256_sub_ps(one, weightA), weightB);
+
+			__m256 distanceX = _mm256_sub_ps(centerX, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weightA, pointAx), _mm256_mul_ps(weightB, pointBx)), _mm256_mul_ps(weightC, pointCx)));
+			__m256 distanceY = _mm256_sub_ps(centerY, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weightA, pointAy), _mm256_mul_ps(weightB, pointBy)), _mm256_mul_ps(weightC, pointCy)));
+			__m256 distanceZ = _mm256_sub_ps(centerZ, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weightA, pointAz), _mm256_mul_ps(weightB, pointBz)), _mm256_mul_ps(weightC, pointCz)));
+
+			__m256 squared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(distanceX, distanceX), _mm256_mul_ps(distanceY, distanceY)), _mm256_mul_ps(distanceZ, distanceZ));
+			__m256 pDistance = _mm256_sqrt_ps(squared);
+
+			__m256 depth = _mm256_loadu_ps(row.depthRow+x);
+			__m256 wasEmpty = _mm256_cmp_ps(depth, empty, _CMP_EQ_OQ);
+			__m256 passed = _mm256_or_ps(_mm256_cmp_ps(depth, pDistance, _CMP_GT_OQ), wasEmpty);
+			int bits = _mm256_movemask_ps(passed);
+
+			if (bits != 0) {
+				_mm256_storeu_ps(row.depthRow+x, _mm256_blendv_ps(depth, pDistance, passed));
+
+				if (row.pass == DEPTH) {
+					__m256i winners = _mm256_loadu_si256((__m256i*) (row.winnersRow+x));
+					_mm256_storeu_si256((__m256i*) (row.winnersRow+x), _mm256_blendv_epi8(winners, number, _mm256_castps_si256(passed)));
+				}
+			}
+
+			if (row.pass == DEPTH_AND_COLOR) {
+				row.overdraw += __builtin_popcount(bits & ~_mm256_movemask_ps(wasEmpty));
+				row.savedOverdraw += 8-__builtin_popcount(bits);
+			}
+
+			storeSpanMask(row, x, bits, 8);
+			row.covered |= bits != 0;
+		}
+	}
+
+	rasterPixelsScalar(row, x, xTo);
+}
+#endif
+
+/*
+ * colors of a row of palette indices, written over the pixels whose index is not 0,
+ * all kernels write the same pixels
+ */
+inline void expandIndicesScalar(const uint8_t* indices, olc::Pixel* pixels, int xFrom, int xTo) {
+	for (int x = xFrom; x < xTo; x++) {
+		if (indices[x] != 0) {
+			pixels[x] = Palette::colors[indices[x]];
+		}
+	}
+}
+
+#ifdef OLC_SSE2
+// 16 indices are tested at once, so that the empty parts of a row are skipped quickly
+inline void expandIndicesSSE2(const uint8_t* indices, olc::Pixel* pixels, int xFrom, int xTo) {
+	int x = xFrom;
+
+	for (; x+16 <= xTo; x += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*) (indices+x));
+		int empty = _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128()));
+
+		if (empty == 0xFFFF) {
+			continue;
+		}
+
+		expandIndicesScalar(indices, pixels, x, x+16);
+	}
+
+	expandIndicesScalar(indices, pixels, x, xTo);
+}
+#endif
+
+#ifdef CLICKERINO_AVX2
+// 8 pixels at once with a gather from the palette, only called after cpuid reported avx2
+__attribute__((target("avx2"))) void expandIndicesAVX2(const uint8_t* indices, olc::Pixel* pixels, int xFrom, int xTo) {
+	int x = xFrom;
+
+	for (; x+8 <= xTo; x += 8) {
+		__m128i block = _mm_loadl_epi64((const __m128i*) (indices+x));
+
+		if (_mm_testz_si128(block, block)) {
+			continue;
+		}
+
+		__m256i index = _mm256_cvtepu8_epi32(block);
+		__m256i color = _mm256_i32gather_epi32((const int*) Palette::colors, index, 4);
+		__m256i empty = _mm256_cmpeq_epi32(index, _mm256_setzero_si256());
+		__m256i old = _mm256_loadu_si256((const __m256i*) (pixels+x));
+
+		_mm256_storeu_si256((__m256i*) (pixels+x), _mm256_blendv_epi8(color, old, empty));
+	}
+
+	expandIndicesScalar(indices, pixels, x, xTo);
+}
+#endif
+
+// an object of the frame being drawn with its projected points, see Engine::projectObject
+class ProjectedObject {
+	public:
+		FrameObject* object;
+		ArenaArray<pair<vector2d, bool>> points2d;
+
+		bool onScreen;
+		int tileMinX;
+		int tileMaxX;
+		int tileMinY;
+		int tileMaxY;
+		float nearest;
+
+		// number of its first triangle in the frame, its triangles are numbered in order from there
+		uint32_t firstTriangle;
+};
+
+/*
+ * a band of whole tile rows of the screen, drawn on its own thread,
+ * no two bands share a pixel or a tile, so they need no locks and draw exactly what one band of the whole screen would
+ */
+class RasterBand {
+	public:
+		int tileMinY;
+		int tileMaxY;
+		int yMin;
+		int yMax;
+
+		uint8_t* spanMask;
+
+		// per object in drawing order, whether it has no pixel in this band that can pass the depth test
+		uint8_t* hidden;
+
+		int overdraw;
+		int savedOverdraw;
+};
+
+class Engine {
+	public:
+		float tre;
+		Camera camera;
+
+		// everything renderObjects needs for one frame, reset when the next frame starts
+		FrameArena arena;
+
+		// buffers of the frame being drawn, in the arena
+		int width;
+		int height;
+		float* depthBuffer;
+
+		// with the prepass, per pixel the number of the triangle that was last written to the depth buffer there
+		uint32_t* winners;
+
+		// in indexed mode, per pixel the palette index of its color, 0 where nothing was drawn, and per row the columns that may be drawn
+		uint8_t* indices;
+		int* indexedMinX;
+		int* indexedMaxX;
+
+		// coarse depth buffer, per tile of tileSize*tileSize pixels the farthest depth in it, or -1 while a pixel of it is empty
+		static const int tileSize = 8;
+		int tilesX;
+		int tilesY;
+		float* tileMax;
+		uint8_t* tileDirty;
+
+		/*
+		 * with the prepass all objects are drawn to the depth buffer first, and then each pixel gets its color once,
+		 * from the triangle that would have been drawn last without a prepass,
+		 * costs a second pass over every triangle, so it is only worth it when much is drawn over
+		 */
+		bool depthPrepass;
+
+		/*
+		 * in indexed mode the rasterizer writes a byte per pixel instead of a color, and every drawn pixel gets its color once at the end,
+		 * needs the normal pixel mode and all colors in the Palette, otherwise colors are drawn directly
+		 */
+		bool indexed;
+
+		// kernel for the pixels of a row, all draw the same pixels, the best one the cpu supports is the default
+		enum Raster { RASTER_SCALAR, RASTER_SSE2, RASTER_AVX2 };
+		Raster raster;
+
+		/*
+		 * of the last frame, objects that were hidden entirely and not drawn, pixels that were drawn over,
+		 * and pixels that were not drawn because something nearer was drawn first
+		 */
+		int culledObjects;
+		int overdraw;
+		int savedOverdraw;
+
+		// of all frames, can be read while another thread draws
+		atomic<uint64_t> totalOverdraw;
+		atomic<uint64_t> totalSavedOverdraw;
+		atomic<uint64_t> renderedFrames;
+
+		Engine(): Engine(0.0000005) {}
+
+		Engine(float tre): tre(tre), depthPrepass(false), indexed(false), raster(bestRaster()), culledObjects(0), overdraw(0), savedOverdraw(0), totalOverdraw(0), totalSavedOverdraw(0), renderedFrames(0) {}
+
+		static Raster bestRaster() {
+#ifdef CLICKERINO_AVX2
+			if (__builtin_cpu_supports("avx2")) {
+				return RASTER_AVX2;
+			}
+#endif
+#ifdef OLC_SSE2
+			return RASTER_SSE2;
+#else
+			return RASTER_SCALAR;
+#endif
+		}
+
+		void setRaster(Raster newRaster) {
+			raster = min(newRaster, bestRaster());
+		}
+
+		void setCamera(Camera _camera) {
+			camera = _camera;
+		}
+
+		pair<vector2d, bool> calculatePoint(vector3d point) {
+			pair<vector2d, bool> result;
+
+			vector3d d = camera.direction;
+			vector3d v = camera.view1;
+			vector3d u = camera.view2;
+			vector3d o = {point.x-camera.center.x, point.y-camera.center.y, point.z-camera.center.z};
+
+			float det =  d.x*v.y*u.z+v.x*u.y*d.z+u.x*d.y*v.z-u.x*v.y*d.z-v.x*d.y*u.z-d.x*u.y*v.z;
+			float aDet = o.x*v.y*u.z+v.x*u.y*o.z+u.x*o.y*v.z-u.x*v.y*o.z-v.x*o.y*u.z-o.x*u.y*v.z;
+			float bDet = d.x*o.y*u.z+o.x*u.y*d.z+u.x*d.y*o.z-u.x*o.y*d.z-o.x*d.y*u.z-d.x*u.y*o.z;
+			float cDet = d.x*v.y*o.z+v.x*o.y*d.z+o.x*d.y*v.z-o.x*v.y*d.z-v.x*d.y*o.z-d.x*o.y*v.z;
+
+			float a = aDet/det;
+			float b = bDet/det;
+			float c = cDet/det;
+
+			if (a <= 0) {
+				result.second = false;
+
+				return result;
+			} else {
+				float xMultiplier = (b/a+1.0)/2.0;
+				float yMultiplier = (c/a+1.0)/2.0;
+
+				result.second = true;
+				result.first = {xMultiplier, yMultiplier};
+
+				return result;
+			}
+		}
+
+		// into points2d, which holds as many points, so that it can be called while other threads use the arena
+		void calculatePoints(const ArenaArray<vector3d>& points, ArenaArray<pair<vector2d, bool>>& points2d) {
+			for (size_t index = 0; index < points.size(); index++) {
+				points2d[index] = calculatePoint(points[index]);
+			}
+		}
+
+		float calculateDistance(vector3d point) {
+			vector3d center = camera.center;
+			float distance = sqrt(powf(center.x-point.x, 2)+powf(center.y-point.y, 2)+powf(center.z-point.z, 2));
+
+			return distance;
+		}
+
+		vector<float> calculateDistances(vector<vector3d> points) {
+			vector<float> distances;
+
+			for (vector<vector3d>::iterator point = points.begin(); point != points.end(); ++point) {
+				distances.push_back(calculateDistance(*point));
+			}
+
+			return distances;
+		}
+
+		/*
+		 * true when no pixel of the object in the band can pass the depth test, so when every tile of the band its projection touches is full
+		 * and farther away than the nearest point of its bounding box, with a margin so that no pixel is ever lost
+		 */
+		bool isHidden(ProjectedObject& projected, RasterBand& band) {
+			if (!projected.onScreen) {
+				return true;
+			}
+
+			// pixels on the edge of a triangle can interpolate to points a little outside of it
+			float nearest = projected.nearest-0.5f;
+
+			for (int tileY = max(projected.tileMinY, band.tileMinY); tileY <= min(projected.tileMaxY, band.tileMaxY); tileY++) {
+				for (int tileX = projected.tileMinX; tileX <= projected.tileMaxX; tileX++) {
+					int tile = tileY*tilesX+tileX;
+
+					if (tileDirty[tile]) {
+						updateTile(tileX, tileY);
+					}
+
+					if (tileMax[tile] == -1 || nearest < tileMax[tile]) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		void updateTile(int tileX, int tileY) {
+			int tile = tileY*tilesX+tileX;
+			float farthest = 0;
+
+			for (int y = tileY*tileSize; y < min((tileY+1)*tileSize, height); y++) {
+				for (int x = tileX*tileSize; x < min((tileX+1)*tileSize, width); x++) {
+					float depth = depthBuffer[y*width+x];
+
+					if (depth == -1) {
+						farthest = -1;
+						break;
+					}
+					if (depth > farthest) {
+						farthest = depth;
+					}
+				}
+
+				if (farthest == -1) {
+					break;
+				}
+			}
+
+			tileMax[tile] = farthest;
+			tileDirty[tile] = 0;
+		}
+
+		/*
+		 * screen bounds and distance of an object, the tiles are widened by 2 pixels for rounding in the rasterizer,
+		 * projected.points2d has to be allocated already
+		 */
+		void projectObject(FrameObject& object, ProjectedObject& projected) {
+			projected.object = &object;
+
+			const ArenaArray<vector3d>& points3d = object.points;
+			calculatePoints(points3d, projected.points2d);
+
+			bool anyProjected = false;
+			float minX = 0;
+			float maxX = 0;
+			float minY = 0;
+			float maxY = 0;
+
+			for (size_t index = 0; index < projected.points2d.size(); index++) {
+				if (projected.points2d[index].second) {
+					float x = projected.points2d[index].first.x*width;
+					float y = projected.points2d[index].first.y*height;
+
+					if (!anyProjected || x < minX) {
+						minX = x;
+					}
+					if (!anyProjected || x > maxX) {
+						maxX = x;
+					}
+					if (!anyProjected || y < minY) {
+						minY = y;
+					}
+					if (!anyProjected || y > maxY) {
+						maxY = y;
+					}
+
+					anyProjected = true;
+				}
+			}
+
+			// triangles with a point behind the camera are never drawn
+			projected.onScreen = anyProjected && maxX+2 >= 0 && minX-2 <= width-1 && maxY+2 >= 0 && minY-2 <= height-1;
+			projected.nearest = 0;
+
+			if (!projected.onScreen) {
+				return;
+			}
+
+			projected.tileMinX = max((int) floor(minX)-2, 0)/tileSize;
+			projected.tileMaxX = min((int) ceil(maxX)+2, width-1)/tileSize;
+			projected.tileMinY = max((int) floor(minY)-2, 0)/tileSize;
+			projected.tileMaxY = min((int) ceil(maxY)+2, height-1)/tileSize;
+
+			vector3d boxMin = points3d[0];
+			vector3d boxMax = points3d[0];
+
+			for (const vector3d* point = points3d.begin(); point != points3d.end(); point++) {
+				boxMin = {min(boxMin.x, point->x), min(boxMin.y, point->y), min(boxMin.z, point->z)};
+				boxMax = {max(boxMax.x, point->x), max(boxMax.y, point->y), max(boxMax.z, point->z)};
+			}
+
+			vector3d center = camera.center;
+			vector3d outside = {max(max(boxMin.x-center.x, center.x-boxMax.x), 0.0f), max(max(boxMin.y-center.y, center.y-boxMax.y), 0.0f), max(max(boxMin.z-center.z, center.z-boxMax.z), 0.0f)};
+
+			projected.nearest = sqrt(outside.x*outside.x+outside.y*outside.y+outside.z*outside.z);
+		}
+
+		// stable two pass radix sort on the distance quantized to 16 bits, 1/64 units up to 1024 units
+		void sortFrontToBack(ArenaArray<ProjectedObject*>& order) {
+			ArenaArray<ProjectedObject*> sorted(arena, order.size());
+			ArenaArray<uint16_t> keys(arena, order.size());
+
+			for (size_t index = 0; index < order.size(); index++) {
+				keys[index] = (uint16_t) min(order[index]->nearest*64, 65535.0f);
+			}
+
+			ArenaArray<uint16_t> sortedKeys(arena, order.size());
+
+			for (int shift = 0; shift < 16; shift += 8) {
+				size_t offsets[257] = {0};
+
+				for (size_t index = 0; index < order.size(); index++) {
+					offsets[((keys[index] >> shift) & 255)+1]++;
+				}
+				for (int digit = 0; digit < 256; digit++) {
+					offsets[digit+1] += offsets[digit];
+				}
+				for (size_t index = 0; index < order.size(); index++) {
+					size_t target = offsets[(keys[index] >> shift) & 255]++;
+
+					sorted[target] = order[index];
+					sortedKeys[target] = keys[index];
+				}
+
+				swap(order.data, sorted.data);
+				swap(keys.data, sortedKeys.data);
+			}
+		}
+
+		// into the top left width*height pixels of the draw target
+		void renderObjects(ArenaArray<FrameObject>& objects, int _width, int _height, olc::PixelGameEngine& pgengine) {
+			arena.reset();
+
+			olc::JobSystem& jobs = pgengine.GetJobs();
+
+			width = _width;
+			height = _height;
+			depthBuffer = arena.allocate<float>(width*height);
+			winners = nullptr;
+			indices = nullptr;
+
+			for (int x = 0; x < width; x++) {
+				for (int y = 0; y < height; y++) {
+					depthBuffer[y*width+x] = -1;
+				}
+			}
+
+			tilesX = (width+tileSize-1)/tileSize;
+			tilesY = (height+tileSize-1)/tileSize;
+			tileMax = arena.allocate<float>(tilesX*tilesY);
+			tileDirty = arena.allocate<uint8_t>(tilesX*tilesY);
+
+			for (int tile = 0; tile < tilesX*tilesY; tile++) {
+				tileMax[tile] = -1;
+				tileDirty[tile] = 0;
+			}
+
+			/* nearest objects first, so that hidden pixels fail the depth test instead of being drawn over */
+
+			ArenaArray<ProjectedObject> projected(arena, objects.size());
+			ArenaArray<ProjectedObject*> order(arena, objects.size());
+
+			// the arena is only used from this thread
+			for (size_t index = 0; index < objects.size(); index++) {
+				projected[index].points2d = ArenaArray<pair<vector2d, bool>>(arena, objects[index].points.size());
+				order[index] = &projected[index];
+			}
+
+			jobs.ParallelFor(objects.size(), 64, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t index = begin; index < end; index++) {
+					projectObject(objects[index], projected[index]);
+				}
+			});
+
+			sortFrontToBack(order);
+
+			uint32_t triangles = 0;
+
+			for (size_t index = 0; index < order.size(); index++) {
+				order[index]->firstTriangle = triangles;
+				triangles += order[index]->object->mesh->triangles.size();
+			}
+
+			/* bands, a few per thread so that a thread with an empty band can take over another one */
+
+			int bandCount = jobs.GetWorkerCount() == 0 ? 1 : min(tilesY, (int) (jobs.GetWorkerCount()+1)*4);
+			ArenaArray<RasterBand> bands(arena, bandCount);
+
+			for (int index = 0; index < bandCount; index++) {
+				RasterBand& band = bands[index];
+
+				band.tileMinY = index*tilesY/bandCount;
+				band.tileMaxY = (index+1)*tilesY/bandCount-1;
+				band.yMin = band.tileMinY*tileSize;
+				band.yMax = min((band.tileMaxY+1)*tileSize, height)-1;
+				band.spanMask = arena.allocate<uint8_t>(width);
+				band.hidden = arena.allocate<uint8_t>(order.size());
+				band.overdraw = 0;
+				band.savedOverdraw = 0;
+			}
+
+			if (depthPrepass) {
+				winners = arena.allocate<uint32_t>(width*height);
+				memset(winners, 255, width*height*sizeof(uint32_t));
+			}
+
+			if (indexed && !Palette::overflowed && pgengine.GetPixelMode() == olc::Pixel::NORMAL) {
+				indices = arena.allocate<uint8_t>(width*height);
+				memset(indices, 0, width*height);
+				indexedMinX = arena.allocate<int>(height);
+				indexedMaxX = arena.allocate<int>(height);
+
+				for (int y = 0; y < height; y++) {
+					indexedMinX[y] = width;
+					indexedMaxX[y] = -1;
+				}
+			}
+
+			/* drawing */
+
+			jobs.ParallelFor(bandCount, 1, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t bandIndex = begin; bandIndex < end; bandIndex++) {
+					RasterBand& band = bands[bandIndex];
+
+					for (size_t index = 0; index < order.size(); index++) {
+						band.hidden[index] = isHidden(*order[index], band);
+
+						if (!band.hidden[index]) {
+							drawObject(*order[index], depthPrepass ? DEPTH : DEPTH_AND_COLOR, band, pgengine);
+						}
+					}
+
+					if (depthPrepass) {
+						for (size_t index = 0; index < order.size(); index++) {
+							if (!band.hidden[index]) {
+								drawObject(*order[index], COLOR, band, pgengine);
+							}
+						}
+					}
+
+					if (indices != nullptr) {
+						expandIndices(band, pgengine);
+					}
+				}
+			});
+
+			culledObjects = 0;
+			overdraw = 0;
+			savedOverdraw = 0;
+
+			for (size_t index = 0; index < order.size(); index++) {
+				bool hidden = true;
 
-		Camera() {}
+				for (int bandIndex = 0; bandIndex < bandCount; bandIndex++) {
+					hidden = hidden && bands[bandIndex].hidden[index];
+				}
 
-		Camera(vector3d center, vector3d direction, vector3d view1, vector3d view2): center(center), direction(direction), view1(view1), view2(view2) {}
-};
+				if (hidden) {
+					culledObjects++;
+				}
+			}
 
-class Engine {
-	public:
-		float tre;
-		Camera camera;
+			for (int bandIndex = 0; bandIndex < bandCount; bandIndex++) {
+				overdraw += bands[bandIndex].overdraw;
+				savedOverdraw += bands[bandIndex].savedOverdraw;
+			}
 
-		Engine() {
-			tre = 0.0000005;
+			totalOverdraw.fetch_add(overdraw, memory_order_relaxed);
+			totalSavedOverdraw.fetch_add(savedOverdraw, memory_order_relaxed);
+			renderedFrames.fetch_add(1, memory_order_relaxed);
 		}
 
-		Engine(float tre): tre(tre) {}
-
-		void setCamera(Camera _camera) {
-			camera = _camera;
+		// colors of the indices of the band into the draw target
+		void expandIndices(RasterBand& band, olc::PixelGameEngine& pgengine) {
+			olc::Sprite* target = pgengine.GetDrawTarget();
+
+			for (int y = band.yMin; y <= band.yMax; y++) {
+				const uint8_t* indicesRow = indices+y*width;
+				olc::Pixel* pixels = target->GetRow(y);
+
+				int xFrom = indexedMinX[y];
+				int xTo = indexedMaxX[y]+1;
+
+				if (raster == RASTER_AVX2) {
+#ifdef CLICKERINO_AVX2
+					expandIndicesAVX2(indicesRow, pixels, xFrom, xTo);
+#endif
+				} else if (raster == RASTER_SSE2) {
+#ifdef OLC_SSE2
+					expandIndicesSSE2(indicesRow, pixels, xFrom, xTo);
+#endif
+				} else {
+					expandIndicesScalar(indicesRow, pixels, xFrom, xTo);
+				}
+			}
 		}
 
-		pair<vector2d, bool> calculatePoint(vector3d point) {
-			pair<vector2d, bool> result;
+		// the rows of the object in the band
+		void drawObject(ProjectedObject& projected, RasterPass pass, RasterBand& band, olc::PixelGameEngine& pgengine) {
+			const FrameObject& object = *projected.object;
+			const ArenaArray<vector3d>& points3d = object.points;
+			const vector<tuple<tuple<int, int, int>, Material>>& triangles = object.mesh->triangles;
 
-			vector3d d = camera.direction;
-			vector3d v = camera.view1;
-			vector3d u = camera.view2;
-			vector3d o = {point.x-camera.center.x, point.y-camera.center.y, point.z-camera.center.z};
+			for (int index = 0; index < triangles.size(); index++) {
+				const tuple<tuple<int, int, int>, Material>& triangle = triangles[index];
+				uint32_t number = projected.firstTriangle+index;
 
-			float det =  d.x*v.y*u.z+v.x*u.y*d.z+u.x*d.y*v.z-u.x*v.y*d.z-v.x*d.y*u.z-d.x*u.y*v.z;
-			float aDet = o.x*v.y*u.z+v.x*u.y*o.z+u.x*o.y*v.z-u.x*v.y*o.z-v.x*o.y*u.z-o.x*u.y*v.z;
-			float bDet = d.x*o.y*u.z+o.x*u.y*d.z+u.x*d.y*o.z-u.x*o.y*d.z-o.x*d.y*u.z-d.x*u.y*o.z;
-			float cDet = d.x*v.y*o.z+v.x*o.y*d.z+o.x*d.y*v.z-o.x*v.y*d.z-v.x*d.y*o.z-d.x*o.y*v.z;
+				tuple<int, int, int> xtriangle = get<0>(triangle);
+				int a = get<0>(xtriangle);
+				int b = get<1>(xtriangle);
+				int c = get<2>(xtriangle);
 
-			float a = aDet/det;
-			float b = bDet/det;
-			float c = cDet/det;
+				if (projected.points2d[a].second && projected.points2d[b].second && projected.points2d[c].second) {
+					olc::Pixel color = get<1>(triangle).color;
+					uint8_t paletteIndex = get<1>(triangle).paletteIndex;
 
-			if (a <= 0) {
-				result.second = false;
+					/* points in 28.4 fixed point, wound so that the area is positive */
 
-				return result;
-			} else {
-				float xMultiplier = (b/a+1.0)/2.0;
-				float yMultiplier = (c/a+1.0)/2.0;
+					int64_t pointAx = toFixed(projected.points2d[a].first.x*width);
+					int64_t pointAy = toFixed(projected.points2d[a].first.y*height);
+					int64_t pointBx = toFixed(projected.points2d[b].first.x*width);
+					int64_t pointBy = toFixed(projected.points2d[b].first.y*height);
+					int64_t pointCx = toFixed(projected.points2d[c].first.x*width);
+					int64_t pointCy = toFixed(projected.points2d[c].first.y*height);
 
-				result.second = true;
-				result.first = {xMultiplier, yMultiplier};
+					vector3d point3dA = points3d[a];
+					vector3d point3dB = points3d[b];
+					vector3d point3dC = points3d[c];
 
-				return result;
-			}
-		}
+					int64_t area = (pointBx-pointAx)*(pointCy-pointAy)-(pointBy-pointAy)*(pointCx-pointAx);
 
-		vector<pair<vector2d, bool>> calculatePoints(vector<vector3d> points) {
-			vector<pair<vector2d, bool>> points2d;
+					// covers no pixel center
+					if (area == 0) {
+						continue;
+					}
 
-			for (vector<vector3d>::iterator point = points.begin(); point != points.end(); ++point) {
-				points2d.push_back(calculatePoint(*point));
-			}
+					if (area < 0) {
+						swap(pointBx, pointCx);
+						swap(pointBy, pointCy);
+						swap(point3dB, point3dC);
+						area = -area;
+					}
 
-			return points2d;
-		}
+					Edge edgeBC(pointBx, pointBy, pointCx, pointCy);
+					Edge edgeCA(pointCx, pointCy, pointAx, pointAy);
+					Edge edgeAB(pointAx, pointAy, pointBx, pointBy);
 
-		float calculateDistance(vector3d point) {
-			vector3d center = camera.center;
-			float distance = sqrt(powf(center.x-point.x, 2)+powf(center.y-point.y, 2)+powf(center.z-point.z, 2));
+					float invArea = 1.0f/area;
 
-			return distance;
-		}
+					RasterRow row;
+					row.pass = pass;
+					row.number = number;
+					row.pointA = point3dA;
+					row.pointB = point3dB;
+					row.pointC = point3dC;
+					row.center = camera.center;
+					row.spanMask = band.spanMask;
+					row.overdraw = 0;
+					row.savedOverdraw = 0;
 
-		vector<float> calculateDistances(vector<vector3d> points) {
-			vector<float> distances;
+					// edge values change by the same amount from pixel to pixel of a row
+					row.edgeStepA = edgeBC.dy*16;
+					row.edgeStepB = edgeCA.dy*16;
+					row.invArea = invArea;
+					// inside the triangle each edge value is between 0 and the area
+					row.narrow = area <= INT32_MAX;
 
-			for (vector<vector3d>::iterator point = points.begin(); point != points.end(); ++point) {
-				distances.push_back(calculateDistance(*point));
-			}
+					/* rows whose pixel centers can be inside */
 
-			return distances;
-		}
+					int64_t minY = min(pointAy, min(pointBy, pointCy));
+					int64_t maxY = max(pointAy, max(pointBy, pointCy));
 
-		void renderObjects(vector<Object> objects, olc::PixelGameEngine pgengine) {
-			int width = pgengine.ScreenWidth();
-			int height = pgengine.ScreenHeight();
-			float *depthBuffer = new float[width*height];
+					int yStart = (int) max(ceilDiv(minY-8, 16), (int64_t) band.yMin);
+					int yEnd = (int) min(floorDiv(maxY-8, 16), (int64_t) band.yMax);
 
-			for (int x = 0; x < width; x++) {
-				for (int y = 0; y < height; y++) {
-					depthBuffer[y*width+x] = -1;
-				}
-			}
+					for (int y = yStart; y <= yEnd; y++) {
+						int64_t sampleY = y*16+8;
 
-			for (vector<Object>::iterator xobject = objects.begin(); xobject != objects.end(); xobject++) {
-				Object object = *xobject;
-
-				vector<vector3d> points3d = object.getPoints();
-				vector<pair<vector2d, bool>> xpoints2d = calculatePoints(points3d);
-
-				// for (vector<tuple<tuple<int, int, int>, Material>>::iterator triangle = object.triangles.begin(); triangle != object.triangles.end(); ++triangle) {
-				for (int index = 0; index < object.triangles.size(); index++) {
-					tuple<tuple<int, int, int>, Material> triangle = object.triangles[index];
-
-					tuple<int, int, int> xtriangle = get<0>(triangle);
-					int a = get<0>(xtriangle);
-					int b = get<1>(xtriangle);
-					int c = get<2>(xtriangle);
-
-					pair<vector2d, bool> xpointA = xpoints2d[a];
-					pair<vector2d, bool> xpointB = xpoints2d[b];
-					pair<vector2d, bool> xpointC = xpoints2d[c];
-
-					if (xpointA.second && xpointB.second && xpointC.second) {
-						
-						/* seting up variables */
-
-						Material material = get<1>(triangle);
-						olc::Pixel color = material.color;
-
-						vector2d unspointA = xpointA.first;
-						vector2d unspointB = xpointB.first;
-						vector2d unspointC = xpointC.first;
-
-						unspointA.x *= width;
-						unspointB.x *= width;
-						unspointC.x *= width;
-						unspointA.y *= height;
-						unspointB.y *= height;
-						unspointC.y *= height;
-
-						vector2d pointA;
-						vector2d pointB;
-						vector2d pointC;
-
-						vector3d unspoint3dA = points3d[a];
-						vector3d unspoint3dB = points3d[b];
-						vector3d unspoint3dC = points3d[c];
-
-						vector3d point3dA;
-						vector3d point3dB;
-						vector3d point3dC;
-
-						/* sorting triangle points */
-
-						if (unspointA.y <= unspointB.y && unspointA.y <= unspointC.y) {
-							pointA = unspointA;
-							point3dA = unspoint3dA;
-							if (unspointB.y <= unspointC.y) {
-								pointB = unspointB;
-								point3dB = unspoint3dB;
-								pointC = unspointC;
-								point3dC = unspoint3dC;
-							} else {
-								pointB = unspointC;
-								point3dB = unspoint3dC;
-								pointC = unspointB;
-								point3dC = unspoint3dB;
-							}
+						/* span of the row that is inside all three edges */
 
-						} else if (unspointB.y <= unspointA.y && unspointB.y <= unspointC.y) {
-							pointA = unspointB;
-							point3dA = unspoint3dB;
-							if (unspointA.y <= unspointC.y) {
-								pointB = unspointA;
-								point3dB = unspoint3dA;
-								pointC = unspointC;
-								point3dC = unspoint3dC;
-							} else {
-								pointB = unspointC;
-								point3dB = unspoint3dC;
-								pointC = unspointA;
-								point3dC = unspoint3dA;
-							}
+						int xStart = 0;
+						int xEnd = width-1;
 
-						} else if (unspointC.y <= unspointB.y && unspointC.y <= unspointA.y) {
-							pointA = unspointC;
-							point3dA = unspoint3dC;
-							if (unspointB.y <= unspointA.y) {
-								pointB = unspointB;
-								point3dB = unspoint3dB;
-								pointC = unspointA;
-								point3dC = unspoint3dA;
-							} else {
-								pointB = unspointA;
-								point3dB = unspoint3dA;
-								pointC = unspointB;
-								point3dC = unspoint3dB;
-							}
+						if (!edgeBC.clipRow(sampleY, xStart, xEnd) || !edgeCA.clipRow(sampleY, xStart, xEnd) || !edgeAB.clipRow(sampleY, xStart, xEnd)) {
+							continue;
 						}
 
-						/* seting up variables */
-
-						int pointAx = (int) pointA.x;
-						int pointAy = (int) pointA.y;
-						int pointBx = (int) pointB.x;
-						int pointBy = (int) pointB.y;
-						int pointCx = (int) pointC.x;
-						int pointCy = (int) pointC.y;
-
-						int l = pointCy-pointAy;
-						int l1 = pointBy-pointAy;
-						int l2 = pointCy-pointBy;
-	
-						float d = (pointAx-pointCx)/((float) (pointAy-pointCy));
-
-						vector2d u = {(float) pointBx-pointAx, (float) pointBy-pointAy};
-						vector2d v = {(float) pointCx-pointBx, (float) pointCy-pointBy};
-						float det = u.x*v.y-v.x*u.y;
-
-						/* drawing top half of triangle */
-
-						if (l1 > 0) {
-							float d1 = (pointAx-pointBx)/((float) (pointAy-pointBy));
-							float x1 = pointAx;
-							float x2 = pointAx;
-
-							bool dIsRight = d1 < d;
-
-							for (int y = pointAy; y <= pointBy; y++) {
-								for (int x = (int) x1; x <= (int) x2; x++) {
-									if (x >= 0 && x < width && y >= 0 && y < height) {
-										float kDet = (x-pointAx)*v.y-v.x*(y-pointAy);
-										float k = kDet/det;
-										float lDet = u.x*(y-pointAy)-(x-pointAx)*u.y;
-										float l = lDet/det;
-
-										float point3dx = point3dA.x+k*(point3dB.x-point3dA.x)+l*(point3dC.x-point3dB.x);
-										float point3dy = point3dA.y+k*(point3dB.y-point3dA.y)+l*(point3dC.y-point3dB.y);
-										float point3dz = point3dA.z+k*(point3dB.z-point3dA.z)+l*(point3dC.z-point3dB.z);
-
-										float pDistance = calculateDistance({point3dx, point3dy, point3dz});
-									
-										int depthBufferIndex = y*width+x;
-										if (depthBuffer[depthBufferIndex] > pDistance || depthBuffer[depthBufferIndex] == -1) {
-											pgengine.Draw(x, y, color);
-
-											depthBuffer[depthBufferIndex] = pDistance;
-										}
-									}
+						/* depth tested pixels are written as one span */
+
+						row.edgeA = edgeBC.at(8, sampleY);
+						row.edgeB = edgeCA.at(8, sampleY);
+						row.depthRow = depthBuffer+y*width;
+						row.winnersRow = winners != nullptr ? winners+y*width : nullptr;
+						row.xStart = xStart;
+						row.covered = false;
+
+						if (raster == RASTER_AVX2) {
+#ifdef CLICKERINO_AVX2
+							rasterPixelsAVX2(row, xStart, xEnd);
+#endif
+						} else if (raster == RASTER_SSE2) {
+#ifdef OLC_SSE2
+							rasterPixelsSSE2(row, xStart, xEnd);
+#endif
+						} else {
+							rasterPixelsScalar(row, xStart, xEnd);
+						}
+
+						if (row.covered) {
+							if (pass != DEPTH && indices != nullptr) {
+								uint8_t* indicesRow = indices+y*width;
+
+								for (int x = xStart; x <= xEnd; x++) {
+									indicesRow[x] = band.spanMask[x-xStart] ? paletteIndex : indicesRow[x];
 								}
 
-								if (dIsRight) {
-									x1 += d1;
-									x2 += d;
-								} else {
-									x1 += d;
-									x2 += d1;
+								indexedMinX[y] = min(indexedMinX[y], xStart);
+								indexedMaxX[y] = max(indexedMaxX[y], xEnd);
+							} else if (pass != DEPTH) {
+								pgengine.DrawSpan(xStart, xEnd, y, color, band.spanMask);
+							}
+
+							if (pass != COLOR) {
+								for (int tileX = xStart/tileSize; tileX <= xEnd/tileSize; tileX++) {
+									tileDirty[(y/tileSize)*tilesX+tileX] = 1;
 								}
 							}
 						}
+					}
+
+					band.overdraw += row.overdraw;
+					band.savedOverdraw += row.savedOverdraw;
+				}
+			}
+		}
+};
 
-						/* drawing bottom half of triangle */
 
-						if (l2 > 0) {
-							float d2 = (pointBx-pointCx)/((float) (pointBy-pointCy));
-							float x1 = pointCx;
-							float x2 = pointCx;
 
-							bool dIsRight = d2 < d;
+/*
+ * share of the screen resolution that 3d is drawn at, adjusted every frame so that drawing takes about budget seconds,
+ * drawing time grows with the pixel count, so with the square of the scale
+ */
+class RenderScale {
+	public:
+		// 0 keeps the full resolution
+		float budget;
+		float minScale;
+		float scale;
 
-							for (int y = pointCy; y > pointBy; y--) {
-								for (int x = (int) x1; x <= (int) x2; x++) {
-									if (x >= 0 && x < width && y >= 0 && y < height) {
-										float kDet = (x-pointAx)*v.y-v.x*(y-pointAy);
-										float k = kDet/det;
-										float lDet = u.x*(y-pointAy)-(x-pointAx)*u.y;
-										float l = lDet/det;
+		RenderScale(): RenderScale(0) {}
 
-										float point3dx = point3dA.x+k*(point3dB.x-point3dA.x)+l*(point3dC.x-point3dB.x);
-										float point3dy = point3dA.y+k*(point3dB.y-point3dA.y)+l*(point3dC.y-point3dB.y);
-										float point3dz = point3dA.z+k*(point3dB.z-point3dA.z)+l*(point3dC.z-point3dB.z);
+		RenderScale(float budget): budget(budget), minScale(0.25), scale(1) {}
 
-										float pDistance = calculateDistance({point3dx, point3dy, point3dz});
-									
-										int depthBufferIndex = y*width+x;
-										if (depthBuffer[depthBufferIndex] > pDistance || depthBuffer[depthBufferIndex] == -1) {
-											pgengine.Draw(x, y, color);
+		void update(float renderTime) {
+			if (budget <= 0 || renderTime <= 0) {
+				return;
+			}
 
-											depthBuffer[depthBufferIndex] = pDistance;
-										}
-									}
-								}
+			float target = min(max(scale*sqrt(budget/renderTime), minScale), 1.0f);
 
-								if (!dIsRight) {
-									x1 -= d2;
-									x2 -= d;
-								} else {
-									x1 -= d;
-									x2 -= d2;
-								}
-							}
-						}
-					}
-				}
+			// small differences are noise, and half way at a time so that one slow frame does not halve the resolution
+			if (fabs(target-scale) > 0.02f*scale) {
+				scale += (target-scale)/2;
 			}
+		}
 
-			delete[] depthBuffer;
+		int size(int screenSize) {
+			return max((int) (screenSize*scale), 1);
 		}
 };
 
@@ -572,46 +1854,128 @@ class Engine {
 
 class State {
 	public:
-		string name;
+		// index into StateManager::states, ids are handed out by the application and should be small
+		int id;
+
+		State() {
+			id = -1;
+		}
+
+		State(int id): id(id) {}
 
-		State() {}
+		virtual ~State() {}
 
-		State(string name): name(name) {}
+		// builds what onStart needs ahead of time on a background thread, see StateManager::prepareState
+		virtual void onPrepare() {}
 
 		virtual void onStart() {}
 
 		virtual bool onUpdate(float elapsedTime) {}
 
+		// draws what onUpdate left in the given frame slot, may run on another thread than onUpdate
+		virtual void onRender(int slot) {}
+
 		virtual void onEnd() {}
 };
 
 class StateManager {
 	public:
-		map<string, State*> states;
-		string activeState;
+		// owned, deleted with the manager
+		vector<State*> states;
+		State* activeState;
+
+		// transition asked for by setState, carried out before the next update
+		State* pendingState;
+
+		// state whose onUpdate filled each frame slot, that one also renders it
+		vector<State*> frameStates;
+
+		// onPrepare running in the background, one per state id
+		vector<thread> preparing;
+
+		StateManager() {
+			activeState = nullptr;
+			pendingState = nullptr;
+
+			frameStates.resize(1, nullptr);
+		}
+
+		~StateManager() {
+			for (vector<thread>::iterator prepare = preparing.begin(); prepare != preparing.end(); prepare++) {
+				if (prepare->joinable()) {
+					prepare->join();
+				}
+			}
+
+			for (vector<State*>::iterator state = states.begin(); state != states.end(); state++) {
+				delete *state;
+			}
+		}
 
-		StateManager() {}
+		void setFrameSlots(int slots) {
+			frameStates.assign(slots, nullptr);
+		}
 
 		void addState(State* state) {
-			states.insert(make_pair(state->name, state));
+			if (state->id >= (int) states.size()) {
+				states.resize(state->id+1, nullptr);
+				preparing.resize(state->id+1);
+			}
+			states[state->id] = state;
+		}
 
-			activeState = "";
+		// starts onPrepare of a state that is likely to come next, so switching to it does no loading
+		void prepareState(int id) {
+			assert(hasState(id));
+
+			if (!preparing[id].joinable()) {
+				preparing[id] = thread(&State::onPrepare, states[id]);
+			}
 		}
 
-		bool update(float elapsedTime) {
-			if (activeState != "") {
-				return states[activeState]->onUpdate(elapsedTime);
+		bool update(float elapsedTime, int slot) {
+			if (pendingState != nullptr) {
+				applyTransition();
+			}
+
+			frameStates[slot] = activeState;
+
+			if (activeState != nullptr) {
+				return activeState->onUpdate(elapsedTime);
 			} else {
 				return true;
 			}
 		}
 
-		void setState(string newState) {
-			if (activeState != "") {
-				states[activeState]->onEnd();
+		void render(int slot) {
+			if (frameStates[slot] != nullptr) {
+				frameStates[slot]->onRender(slot);
+			}
+		}
+
+		// only queues the change, so states can call this from their own onUpdate, the last call before the next update wins
+		void setState(int id) {
+			assert(hasState(id));
+
+			pendingState = states[id];
+		}
+
+		bool hasState(int id) {
+			return id >= 0 && id < (int) states.size() && states[id] != nullptr;
+		}
+
+		void applyTransition() {
+			// usually long finished, unless the switch came right after prepareState
+			if (preparing[pendingState->id].joinable()) {
+				preparing[pendingState->id].join();
+			}
+
+			if (activeState != nullptr) {
+				activeState->onEnd();
 			}
-			activeState = newState;
-			states[activeState]->onStart();
+			activeState = pendingState;
+			pendingState = nullptr;
+			activeState->onStart();
 		}
 };
 
@@ -621,14 +1985,75 @@ class StateManager {
  * Main: ClickerinoCpp
  */
 
-int randInt(int min, int max) {
-	return rand()%(max-min+1)+min;
-}
+ObjectCache objectCache;
 
-float randFloat(float min, float max, int decimalPlaces) {
-	int mult = pow(10, decimalPlaces);
-	return ((float) randInt(min*mult, max*mult))/mult;
-}
+class Random {
+	public:
+		uint64_t state[4];
+
+		Random() {
+			seed(0);
+		}
+
+		Random(uint64_t seedValue) {
+			seed(seedValue);
+		}
+
+		void seed(uint64_t seedValue) {
+			// splitmix64, so that close seeds still give unrelated states
+			for (int i = 0; i < 4; i++) {
+				seedValue += 0x9E3779B97F4A7C15ull;
+
+				uint64_t z = seedValue;
+				z = (z^(z >> 30))*0xBF58476D1CE4E5B9ull;
+				z = (z^(z >> 27))*0x94D049BB133111EBull;
+				state[i] = z^(z >> 31);
+			}
+		}
+
+		// xoshiro256**
+		uint64_t next() {
+			uint64_t result = rotl(state[1]*5, 7)*9;
+			uint64_t t = state[1] << 17;
+
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = rotl(state[3], 45);
+
+			return result;
+		}
+
+		// uniform in [min, max], multiply-shift with rejection so there is no modulo bias
+		int randInt(int min, int max) {
+			uint32_t range = (uint32_t) (max-min)+1;
+			uint64_t m = (next() >> 32)*range;
+			uint32_t low = (uint32_t) m;
+
+			if (low < range) {
+				uint32_t threshold = (0u-range)%range;
+
+				while (low < threshold) {
+					m = (next() >> 32)*range;
+					low = (uint32_t) m;
+				}
+			}
+
+			return min+(int) (m >> 32);
+		}
+
+		// uniform in [min, max), top 24 bits fill the whole float mantissa
+		float randFloat(float min, float max) {
+			return min+(max-min)*((next() >> 40)*(1.0f/16777216.0f));
+		}
+
+	private:
+		static uint64_t rotl(uint64_t x, int k) {
+			return (x << k)|(x >> (64-k));
+		}
+};
 
 
 
@@ -640,28 +2065,53 @@ class Block {
 		float xVel;
 
 		Object drawObject;
-		vector3d rotation;
+		int orientation;
 
 		Block() {}
 
-		Block(float y, float velMultiplier, vector3d rotation): y(y), rotation(rotation) {
+		Block(float y, float velMultiplier, int orientation): y(y), orientation(orientation) {
 			x = 60;
 
 			xVel = -17*velMultiplier;
 
-			drawObject = Object::loadFromFile("Objects/block");
+			vector3d scale = {1.5, 1.5, 1.5};
+
+			drawObject = objectCache.get("Objects/block");
+			drawObject.setOrientation(orientations()[orientation], scale, objectCache.getOrientation("Objects/block", orientations(), scale, orientation));
+		}
+
+		// every rotation spawn can pick, from -3 to 3 turns on each axis
+		static const vector<vector3d>& orientations() {
+			static vector<vector3d> rotations = []() {
+				vector<vector3d> result;
+
+				for (int turnX = -3; turnX <= 3; turnX++) {
+					for (int turnY = -3; turnY <= 3; turnY++) {
+						for (int turnZ = -3; turnZ <= 3; turnZ++) {
+							result.push_back({turnX*90.0f*(3.14159f/2), turnY*90.0f*(3.14159f/2), turnZ*90.0f*(3.14159f/2)});
+						}
+					}
+				}
+
+				return result;
+			}();
+
+			return rotations;
 		}
 
-		static Block spawn(float velMultiplier) {
-			return Block(randInt(-11, 11), velMultiplier, {randInt(-3, 3)*90.0f, randInt(-3, 3)*90.0f, randInt(-3, 3)*90.0f});
+		static Block spawn(Random& random, float velMultiplier) {
+			float y = random.randInt(-11, 11);
+			int turnX = random.randInt(-3, 3);
+			int turnY = random.randInt(-3, 3);
+			int turnZ = random.randInt(-3, 3);
+
+			return Block(y, velMultiplier, ((turnX+3)*7+turnY+3)*7+turnZ+3);
 		}
 
 		void update(float elapsedTime) {
 			x += xVel*elapsedTime;
 
-			drawObject.setRotation({rotation.x*(3.14159f/2), rotation.y*(3.14159f/2), rotation.z*(3.14159f/2)});
 			drawObject.setPos({x, y, 0});
-			drawObject.setScale({1.5, 1.5, 1.5});
 		}
 
 		bool end() {
@@ -682,7 +2132,7 @@ class Bullet {
 		Bullet(float x, float y): x(x), y(y) {
 			xVel = 35;
 
-			drawObject = Object::loadFromFile("Objects/bullet");
+			drawObject = objectCache.get("Objects/bullet");
 		}
 
 		void update(float elapsedTime) {
@@ -743,8 +2193,10 @@ class Player {
 			health = 3;
 
 			score = 0;
+		}
 
-			drawObject = Object::loadFromFile("Objects/spaceShip");
+		Player(Object drawObject): Player() {
+			this->drawObject = drawObject;
 		}
 
 		void update(float elapsedTime) {
@@ -827,57 +2279,285 @@ class Player {
 			score++;
 		}
 
-		void crash() {
-			health--;
-		}
+		void crash() {
+			health--;
+		}
+
+		bool end() {
+			return health <= 0;
+		}
+};
+
+class End {
+	public:
+		Object drawObject;
+
+		End() {}
+
+		End(Object drawObject): drawObject(drawObject) {}
+
+		void update() {
+			drawObject.setPos({-12+5+1, 0, -1-0.3});
+		}
+};
+
+class GameTier {
+	public:
+		int scoreNeeded;
+		float blockVelMin;
+		float blockVelMax;
+		float nextBlockSpawnMin;
+		float nextBlockSpawnMax;
+
+		GameTier() {}
+
+		GameTier(int scoreNeeded, float blockVelMin, float blockVelMax, float nextBlockSpawnMin, float nextBlockSpawnMax): scoreNeeded(scoreNeeded), blockVelMin(blockVelMin), blockVelMax(blockVelMax), nextBlockSpawnMin(nextBlockSpawnMin), nextBlockSpawnMax(nextBlockSpawnMax) {}
+};
+
+
+
+// a label followed by a value, formatted in place and only when the value changes, so drawing it allocates nothing
+class HudText {
+	public:
+		// NUMBER shows the value in digits, TALLY as that many I's
+		enum Style { NUMBER, TALLY };
+
+		static const int capacity = 32;
+
+		char text[capacity];
+		int labelLength;
+		int value;
+		bool valid;
+		Style style;
+
+		HudText() {
+			text[0] = '\0';
+			labelLength = 0;
+			valid = false;
+			style = NUMBER;
+		}
+
+		HudText(const char* label, Style style = NUMBER): style(style) {
+			labelLength = min((int) strlen(label), capacity/2);
+			memcpy(text, label, labelLength);
+			text[labelLength] = '\0';
+
+			valid = false;
+		}
+
+		void set(int newValue) {
+			if (valid && newValue == value) {
+				return;
+			}
+
+			value = newValue;
+			valid = true;
+
+			int length = labelLength;
+
+			if (style == TALLY) {
+				for (int i = 0; i < value && length < capacity-1; i++) {
+					text[length++] = 'I';
+				}
+			} else {
+				// digits come out lowest first, so they are written backwards into a scratch buffer
+				char digits[12];
+				int count = 0;
+				unsigned int magnitude = value < 0 ? 0u-(unsigned int) value : (unsigned int) value;
+
+				do {
+					digits[count++] = '0'+magnitude%10;
+					magnitude /= 10;
+				} while (magnitude > 0);
+
+				if (value < 0) {
+					text[length++] = '-';
+				}
+				while (count > 0) {
+					text[length++] = digits[--count];
+				}
+			}
+
+			text[length] = '\0';
+		}
+
+		const char* c_str() const {
+			return text;
+		}
+};
+
+class InputLog {
+	public:
+		enum Input { LEFT = 1, RIGHT = 2, UP = 4 };
+
+		static const uint32_t tickRate = 120;
+
+		uint64_t seed;
+		vector<uint8_t> inputs;
+
+		InputLog() {
+			seed = 0;
+		}
+
+		InputLog(uint64_t seed): seed(seed) {}
+
+		void push(uint8_t input) {
+			inputs.push_back(input);
+		}
+
+		/*
+		 * file layout: "CLKR", version, seed, tick rate, tick count and then (input, run length) pairs,
+		 * held keys repeat for many ticks so run length encoding keeps logs of long sessions small
+		 */
+		bool save(string path) {
+			ofstream file(path, ofstream::binary);
+
+			if (!file) {
+				return false;
+			}
+
+			uint32_t version = 1;
+			uint32_t rate = tickRate;
+			uint32_t count = inputs.size();
+			file.write("CLKR", 4);
+			file.write((char*) &version, sizeof(uint32_t));
+			file.write((char*) &seed, sizeof(uint64_t));
+			file.write((char*) &rate, sizeof(uint32_t));
+			file.write((char*) &count, sizeof(uint32_t));
+
+			size_t i = 0;
+			while (i < inputs.size()) {
+				uint8_t input = inputs[i];
+				uint16_t length = 0;
+
+				while (i < inputs.size() && inputs[i] == input && length < 0xFFFF) {
+					length++;
+					i++;
+				}
+
+				file.write((char*) &input, sizeof(uint8_t));
+				file.write((char*) &length, sizeof(uint16_t));
+			}
+
+			file.close();
+
+			return true;
+		}
+
+		bool load(string path) {
+			ifstream file(path, ifstream::binary);
+
+			if (!file) {
+				return false;
+			}
+
+			char magic[4];
+			uint32_t version;
+			uint32_t rate;
+			uint32_t count;
+			file.read(magic, 4);
+			file.read((char*) &version, sizeof(uint32_t));
+			file.read((char*) &seed, sizeof(uint64_t));
+			file.read((char*) &rate, sizeof(uint32_t));
+			file.read((char*) &count, sizeof(uint32_t));
+
+			if (!file || string(magic, 4) != "CLKR" || version != 1 || rate != tickRate) {
+				return false;
+			}
+
+			inputs.clear();
+			inputs.reserve(count);
+
+			while (inputs.size() < count) {
+				uint8_t input;
+				uint16_t length;
+				file.read((char*) &input, sizeof(uint8_t));
+				file.read((char*) &length, sizeof(uint16_t));
 
-		string getHealthString() {
-			string healthString = "";
+				if (!file) {
+					return false;
+				}
 
-			for (int i = 0; i<health; i++) {
-				healthString += "I";
+				inputs.insert(inputs.end(), length, input);
 			}
 
-			return healthString;
-		}
+			file.close();
 
-		string getBulletString() {
-			return to_string(bullets);
+			return true;
 		}
+};
 
-		string getScoreString() {
-			return to_string(score);
+class FrameStats {
+	public:
+		int frames;
+		float total;
+		float min;
+		float max;
+
+		int allocationFrames;
+		AllocationSnapshot allocations;
+		uint64_t maxAllocations;
+		uint64_t maxAllocatedBytes;
+
+		FrameStats() {
+			frames = 0;
+			total = 0;
+			min = 0;
+			max = 0;
+
+			allocationFrames = 0;
+			maxAllocations = 0;
+			maxAllocatedBytes = 0;
 		}
 
-		bool end() {
-			return health <= 0;
+		void add(float frameTime) {
+			if (frames == 0 || frameTime < min) {
+				min = frameTime;
+			}
+			if (frames == 0 || frameTime > max) {
+				max = frameTime;
+			}
+
+			total += frameTime;
+			frames++;
 		}
-};
 
-class End {
-	public:
-		Object drawObject;
+		// frame is what one frame allocated, see Allocations
+		void addAllocations(const AllocationSnapshot& frame) {
+			for (int tag = 0; tag < AllocationSnapshot::maxTags; tag++) {
+				allocations.counts[tag] += frame.counts[tag];
+				allocations.bytes[tag] += frame.bytes[tag];
+			}
 
-		End() {
-			drawObject = Object::loadFromFile("Objects/end");
-		}
+			if (frame.totalCount() > maxAllocations) {
+				maxAllocations = frame.totalCount();
+			}
+			if (frame.totalBytes() > maxAllocatedBytes) {
+				maxAllocatedBytes = frame.totalBytes();
+			}
 
-		void update() {
-			drawObject.setPos({-12+5+1, 0, -1-0.3});
+			allocationFrames++;
 		}
-};
 
-class GameTier {
-	public:
-		int scoreNeeded;
-		float blockVelMin;
-		float blockVelMax;
-		float nextBlockSpawnMin;
-		float nextBlockSpawnMax;
+		void print() {
+			if (frames == 0) {
+				return;
+			}
 
-		GameTier() {}
+			cout << "frames: " << frames << " in " << total << " s" << endl;
+			cout << "frame ms: avg " << 1000*total/frames << ", min " << 1000*min << ", max " << 1000*max << endl;
 
-		GameTier(int scoreNeeded, float blockVelMin, float blockVelMax, float nextBlockSpawnMin, float nextBlockSpawnMax): scoreNeeded(scoreNeeded), blockVelMin(blockVelMin), blockVelMax(blockVelMax), nextBlockSpawnMin(nextBlockSpawnMin), nextBlockSpawnMax(nextBlockSpawnMax) {}
+			if (allocationFrames > 0) {
+				cout << "allocations per frame: avg " << allocations.totalCount()/allocationFrames << " (" << allocations.totalBytes()/allocationFrames << " bytes)";
+				cout << ", max " << maxAllocations << " (" << maxAllocatedBytes << " bytes)" << endl;
+
+				for (int tag = 0; tag < AllocationSnapshot::maxTags; tag++) {
+					if (Allocations::names[tag] != nullptr) {
+						cout << "  " << Allocations::names[tag] << ": avg " << allocations.counts[tag]/allocationFrames << " (" << allocations.bytes[tag]/allocationFrames << " bytes)" << endl;
+					}
+				}
+			}
+		}
 };
 
 
@@ -886,18 +2566,39 @@ class GameTier {
  * Main: Main
  */
 
+enum StateId { MENU, GAME, GAME_OVER, HELP };
+
+enum AllocationTag { ALLOCATION_OTHER, ALLOCATION_SIMULATION, ALLOCATION_RENDER, ALLOCATION_LOADING };
+
 class Demo : public olc::PixelGameEngine {
 	public:
 		StateManager stateManager;
 
+		uint64_t seed;
+		Random random;
+
+		string recordPath;
+		string replayPath;
+		bool replaying;
+		InputLog replay;
+
 		int lastScore;
 
+		bool profiling;
+		bool depthPrepass;
+		Engine::Raster raster;
+		// seconds, see RenderScale
+		float renderBudget;
+		bool bilinearUpscale;
+		bool indexed;
+
 		map<string, olc::Sprite*> sprites;
 
 		Demo();
 
 		bool OnUserCreate() override;
 		bool OnUserUpdate(float elapsedTime) override;
+		bool OnUserRender(uint32_t frameSlot) override;
 };
 
 class MenuState : public State {
@@ -908,35 +2609,35 @@ class MenuState : public State {
 		olc::Sprite* putinImage;
 		bool showPutin;
 
+		bool redraw;
+
 		MenuState(StateManager* stateManager, Demo* pgengine): stateManager(stateManager), pgengine(pgengine) {
-			name = "Menu";
+			id = MENU;
 
 			putinImage = pgengine->sprites["putin"];
 
 			showPutin = true;
 		}
 
-		void onStart() {}
+		void onStart() {
+			pgengine->SetRetainedMode(true);
+			redraw = true;
 
-		bool onUpdate(float elapsedTime) {
-			pgengine->FillRect(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight(), olc::Pixel(255, 255, 255));
+			stateManager->prepareState(GAME);
+		}
 
-			if (showPutin) {
-				pgengine->DrawSprite(250-putinImage->width/2, 170-putinImage->height/2, putinImage);
+		bool onUpdate(float elapsedTime) {
+			// nothing on the menu moves, so it is drawn once and then only kept on screen
+			if (redraw) {
+				pgengine->MarkDirty(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight());
+				redraw = false;
 			}
 
-			int x1 = 250-29*4;
-			int x2 = 250-21*4;
-			int x3 = 250-24*4;
-			pgengine->DrawString(x1, 320, "Press [ SPACE ] to start game", olc::Pixel(0, 0, 0));
-			pgengine->DrawString(x2, 320+20, "Press [ ESC ] to exit", olc::Pixel(0, 0, 0));
-			pgengine->DrawString(x3, 320+40, "Press [ h ] to show help", olc::Pixel(0, 0, 0));
-
 			if (pgengine->GetKey(olc::Key::SPACE).bPressed) {
-				stateManager->setState("Game");
+				stateManager->setState(GAME);
 			}
 			if (pgengine->GetKey(olc::Key::H).bPressed) {
-				stateManager->setState("Help");
+				stateManager->setState(HELP);
 			}
 			if (pgengine->GetKey(olc::Key::ESCAPE).bPressed) {
 				return false;
@@ -945,15 +2646,60 @@ class MenuState : public State {
 			}
 		}
 
+		void onRender(int slot) {
+			pgengine->Clear(olc::Pixel(255, 255, 255));
+
+			if (showPutin) {
+				pgengine->DrawSprite(250-putinImage->width/2, 170-putinImage->height/2, putinImage);
+			}
+
+			int x1 = 250-29*4;
+			int x2 = 250-21*4;
+			int x3 = 250-24*4;
+			pgengine->DrawString(x1, 320, "Press [ SPACE ] to start game", olc::Pixel(0, 0, 0));
+			pgengine->DrawString(x2, 320+20, "Press [ ESC ] to exit", olc::Pixel(0, 0, 0));
+			pgengine->DrawString(x3, 320+40, "Press [ h ] to show help", olc::Pixel(0, 0, 0));
+		}
+
 		void onEnd() {}
 };
 
+// everything GameState::onRender needs, so that the simulation can go on while a frame is drawn
+class GameFrame {
+	public:
+		Camera camera;
+
+		// reset when the slot is filled again, the pipeline is done with it by then
+		FrameArena arena;
+		ArenaArray<FrameObject> objects;
+
+		HudText health;
+		HudText bullets;
+		HudText score;
+
+		// profiler overlay, allocations of the frame before
+		HudText allocations;
+		HudText allocatedBytes;
+		HudText tagAllocations[AllocationSnapshot::maxTags];
+
+		GameFrame(): health("Health: ", HudText::TALLY), bullets("Bullets: "), score("Score: "), allocations("allocs: "), allocatedBytes("bytes: ") {
+			for (int tag = 0; tag < AllocationSnapshot::maxTags; tag++) {
+				if (Allocations::names[tag] != nullptr) {
+					tagAllocations[tag] = HudText((string(Allocations::names[tag])+": ").c_str());
+				}
+			}
+		}
+};
+
 class GameState : public State {
 	public:
 		StateManager* stateManager;
 		Demo* pgengine;
 
+		vector<GameFrame> frames;
+
 		Engine engine;
+		Random random;
 
 		Player player;
 		vector<Bullet> bullets;
@@ -967,11 +2713,29 @@ class GameState : public State {
 		int tier;
 		vector<GameTier> tiers;
 
-		GameState(StateManager* stateManager, Demo* pgengine): stateManager(stateManager), pgengine(pgengine) {
-			name = "Game";
+		float tickTime;
+		float accumulator;
+		bool gameEnd;
+
+		InputLog log;
+		size_t replayTick;
+		FrameStats replayStats;
+
+		AllocationSnapshot lastAllocations;
+
+		// drawn by the render thread only, so not part of a frame
+		HudText culled;
+		HudText overdraw;
+		HudText savedOverdraw;
+		HudText scale;
+
+		// with a render budget 3d is drawn into scene at the resolution of renderScale, and then stretched to the screen
+		RenderScale renderScale;
+		unique_ptr<olc::Sprite> scene;
+
+		GameState(StateManager* stateManager, Demo* pgengine): stateManager(stateManager), pgengine(pgengine), culled("culled: "), overdraw("overdraw: "), savedOverdraw("saved: "), scale("scale %: ") {
+			id = GAME;
 
-			engine = Engine();
-			
 			blockSpawnTime = 3;
 
 			tiers.push_back(GameTier( 4, 1.5, 1.9, 1.5, 2.5));
@@ -979,12 +2743,50 @@ class GameState : public State {
 			tiers.push_back(GameTier(15, 1.9, 2.3, 1.3, 2.2));
 			tiers.push_back(GameTier(21, 2.1, 2.5, 1.2, 2.1));
 			tiers.push_back(GameTier(24, 2.3, 2.7, 1.1, 1.9));
+
+			tickTime = 1.0f/InputLog::tickRate;
+		}
+
+		// every object of a game, kept loaded across games
+		void onPrepare() {
+			AllocationScope scope(ALLOCATION_LOADING);
+
+			vector<string> paths = {"Objects/spaceShip", "Objects/end", "Objects/block", "Objects/bullet"};
+
+			// one object per job, parsing is the slow part of loading
+			pgengine->GetJobs().ParallelFor(paths.size(), 1, [&](uint32_t begin, uint32_t end) {
+				AllocationScope scope(ALLOCATION_LOADING);
+
+				for (uint32_t index = begin; index < end; index++) {
+					objectCache.preload({paths[index]});
+				}
+			});
+
+			objectCache.preloadOrientations("Objects/block", Block::orientations(), {1.5, 1.5, 1.5});
 		}
 
 		void onStart() {
-			player = Player();
+			pgengine->SetRetainedMode(false);
+
+			frames.resize(pgengine->GetFrameSlots());
+
+			engine.depthPrepass = pgengine->depthPrepass;
+			engine.indexed = pgengine->indexed;
+			engine.setRaster(pgengine->raster);
+
+			renderScale = RenderScale(pgengine->renderBudget);
+
+			if (pgengine->replaying) {
+				log = pgengine->replay;
+			} else {
+				// every game gets its own stream, derived from the seed given on the command line
+				log = InputLog(pgengine->random.next());
+			}
+			random = Random(log.seed);
 
-			end = End();
+			player = Player(objectCache.get("Objects/spaceShip"));
+
+			end = End(objectCache.get("Objects/end"));
 
 			bullets.clear();
 			bullets.shrink_to_fit();
@@ -995,21 +2797,58 @@ class GameState : public State {
 			nextBlock = 0;
 
 			tier = 0;
+
+			accumulator = 0;
+			gameEnd = false;
+
+			replayTick = 0;
+			replayStats = FrameStats();
+
+			lastAllocations = Allocations::snapshot();
 		}
 
-		bool onUpdate(float elapsedTime) {
-			pgengine->FillRect(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight(), olc::Pixel(255, 255, 255));
+		uint8_t readInput() {
+			uint8_t input = 0;
+
+			if (pgengine->GetKey(olc::Key::LEFT).bHeld) {
+				input |= InputLog::LEFT;
+			}
+			if (pgengine->GetKey(olc::Key::RIGHT).bHeld) {
+				input |= InputLog::RIGHT;
+			}
+			if (pgengine->GetKey(olc::Key::UP).bHeld) {
+				input |= InputLog::UP;
+			}
 
+			return input;
+		}
+
+		// advances the simulation by exactly one tickTime, everything here has to depend only on input and random
+		void tick(uint8_t input) {
 			GameTier currentTier = tiers[tier];
 			vector<Bullet> newBullets;
 			vector<Block> newBlocks;
 
+			/* user input */
+			if (input & InputLog::RIGHT) {
+				player.accRight(tickTime);
+			}
+			if (input & InputLog::LEFT) {
+				player.accLeft(tickTime);
+			}
+			if (input & InputLog::UP) {
+				tuple<Bullet, bool> shotResult = player.shot();
+				if (get<1>(shotResult)) {
+					bullets.push_back(get<0>(shotResult));
+				}
+			}
+
 			/* player update */
-			player.update(elapsedTime);
+			player.update(tickTime);
 
 			/* bullet update */
 			for (vector<Bullet>::iterator bullet = bullets.begin(); bullet != bullets.end(); bullet++) {
-				bullet->update(elapsedTime);
+				bullet->update(tickTime);
 
 				if (!bullet->end()) {
 					newBullets.push_back(*bullet);
@@ -1019,7 +2858,7 @@ class GameState : public State {
 
 			/* block update */
 			if (nextBlock > 0) {
-				nextBlock -= elapsedTime;
+				nextBlock -= tickTime;
 
 				if (nextBlock < 0 || blocks.size() == 0) {
 					nextBlock = 0;
@@ -1027,13 +2866,13 @@ class GameState : public State {
 			}
 
 			if (nextBlock == 0) {
-				nextBlock = randFloat(currentTier.nextBlockSpawnMin, currentTier.nextBlockSpawnMax, 3);
+				nextBlock = random.randFloat(currentTier.nextBlockSpawnMin, currentTier.nextBlockSpawnMax);
 
-				blocks.push_back(Block::spawn(randFloat(currentTier.blockVelMin, currentTier.blockVelMax, 3)));
+				blocks.push_back(Block::spawn(random, random.randFloat(currentTier.blockVelMin, currentTier.blockVelMax)));
 			}
 
 			for (vector<Block>::iterator block = blocks.begin(); block != blocks.end(); block++) {
-				block->update(elapsedTime);
+				block->update(tickTime);
 
 				if (block->end()) {
 					player.crash();
@@ -1072,69 +2911,200 @@ class GameState : public State {
 			end.update();
 
 			/* player dead */
-			bool gameEnd = player.end();
+			gameEnd = player.end();
 
 			/* tier update */
 			if (tier < tiers.size()-1) {
 				if (player.score >= currentTier.scoreNeeded) {
 					tier++;
-					currentTier = tiers[tier];
 				}
 			}
-			
-			/* drawing 3d */
+		}
+
+		bool onUpdate(float elapsedTime) {
+			/* allocations since the last update, so of one whole frame */
+			AllocationSnapshot allocations = Allocations::snapshot();
+			AllocationSnapshot frameAllocations = allocations.since(lastAllocations);
+			lastAllocations = allocations;
+
+			AllocationScope scope(ALLOCATION_SIMULATION);
+
+			/* simulation */
+			if (pgengine->replaying) {
+				// one tick per frame, so that a replay runs as fast as frames can be drawn
+				if (replayTick > 0) {
+					replayStats.add(elapsedTime);
+
+					if (pgengine->profiling) {
+						replayStats.addAllocations(frameAllocations);
+					}
+				}
+
+				if (replayTick >= log.inputs.size() || gameEnd) {
+					cout << "replay: " << replayTick << " ticks, score " << player.score << endl;
+					replayStats.print();
+
+					// frames still being drawn by the pipeline are not counted yet
+					uint64_t renderedFrames = engine.renderedFrames.load();
+					if (pgengine->profiling && renderedFrames > 0) {
+						cout << "overdraw per frame: avg " << engine.totalOverdraw.load()/renderedFrames << " pixels, saved " << engine.totalSavedOverdraw.load()/renderedFrames << endl;
+					}
+
+					return false;
+				}
+
+				tick(log.inputs[replayTick]);
+				replayTick++;
+			} else {
+				uint8_t input = readInput();
+
+				// fixed timestep, long frames (loading, window dragging) are not caught up completely
+				accumulator += elapsedTime;
+				if (accumulator > 0.25f) {
+					accumulator = 0.25f;
+				}
+
+				while (accumulator >= tickTime && !gameEnd) {
+					tick(input);
+					log.push(input);
+
+					accumulator -= tickTime;
+				}
+			}
+
+			/* frame for rendering */
+			GameFrame& frame = frames[pgengine->GetFrameSlot()];
+
 			vector3d center = {-30.0, player.y, 20.0};
 			vector3d direction = {35.0, 0.0, -20.0};
 			vector3d view1 = {0.0, 20.0, 0.0};
 			vector3d view2 = {-(4.0*5*2)/sqrt(13), 0.0, -(4.0*5*3)/sqrt(13)};
 
-			engine.setCamera(Camera(center, direction, view1, view2));
+			frame.camera = Camera(center, direction, view1, view2);
 
-			vector<Object> renderObjects;
+			frame.arena.reset();
+			frame.objects = ArenaArray<FrameObject>(frame.arena, bullets.size()+blocks.size()+2);
 
-			renderObjects.push_back(player.drawObject);
+			// points are brought up to date on the objects of the simulation, where they stay cached, the frame only gets their values
+			int object = 0;
+			auto addObject = [&](Object& drawObject) {
+				const vector<vector3d>& points = drawObject.getPoints();
+
+				FrameObject& frameObject = frame.objects[object++];
+				frameObject.mesh = drawObject.mesh.get();
+				frameObject.points = ArenaArray<vector3d>(frame.arena, points.size());
+				copy(points.begin(), points.end(), frameObject.points.begin());
+			};
+
+			addObject(player.drawObject);
 
 			for (vector<Bullet>::iterator bullet = bullets.begin(); bullet != bullets.end(); bullet++) {
-				renderObjects.push_back(bullet->drawObject);
+				addObject(bullet->drawObject);
 			}
 
 			for (vector<Block>::iterator block = blocks.begin(); block != blocks.end(); block++) {
-				renderObjects.push_back(block->drawObject);
+				addObject(block->drawObject);
 			}
 
-			renderObjects.push_back(end.drawObject);
+			addObject(end.drawObject);
 
-			engine.renderObjects(renderObjects, (*pgengine));
+			frame.health.set(player.health);
+			frame.bullets.set(player.bullets);
+			frame.score.set(player.score);
 
-			/* drawing 2d */
-			pgengine->DrawString(10, 10+15*0, "Health: "+player.getHealthString(), olc::Pixel(0, 0, 0));
-			pgengine->DrawString(10, 10+15*1, "Bullets: "+player.getBulletString(), olc::Pixel(0, 0, 0));
-			pgengine->DrawString(10, 10+15*2, "Score: "+player.getScoreString(), olc::Pixel(0, 0, 0));
+			if (pgengine->profiling) {
+				frame.allocations.set(frameAllocations.totalCount());
+				frame.allocatedBytes.set(frameAllocations.totalBytes());
 
-			/* user input */
-			if (pgengine->GetKey(olc::Key::RIGHT).bHeld) {
-				player.accRight(elapsedTime);
-			}
-			if (pgengine->GetKey(olc::Key::LEFT).bHeld) {
-				player.accLeft(elapsedTime);
-			}
-			if (pgengine->GetKey(olc::Key::UP).bHeld) {
-				tuple<Bullet, bool> shotResult = player.shot();
-				if (get<1>(shotResult)) {
-					bullets.push_back(get<0>(shotResult));
+				for (int tag = 0; tag < AllocationSnapshot::maxTags; tag++) {
+					frame.tagAllocations[tag].set(frameAllocations.counts[tag]);
 				}
 			}
 
 			/* state changing */
-			if (gameEnd) {
-				stateManager->setState("GameOver");
+			if (gameEnd && !pgengine->replaying) {
+				stateManager->setState(GAME_OVER);
 			}
 
 			return true;
 		}
 
+		void onRender(int slot) {
+			AllocationScope scope(ALLOCATION_RENDER);
+
+			GameFrame& frame = frames[slot];
+
+			/* drawing 3d */
+			engine.setCamera(frame.camera);
+
+			int width = renderScale.size(pgengine->ScreenWidth());
+			int height = renderScale.size(pgengine->ScreenHeight());
+			bool scaled = width < pgengine->ScreenWidth() || height < pgengine->ScreenHeight();
+			olc::Sprite* screen = pgengine->GetDrawTarget();
+
+			if (scaled) {
+				// screen sized, made again when the screen has another size than the one it was made for
+				if (scene == nullptr || scene->width != pgengine->ScreenWidth() || scene->height != pgengine->ScreenHeight()) {
+					scene.reset(new olc::Sprite(pgengine->ScreenWidth(), pgengine->ScreenHeight()));
+				}
+
+				pgengine->SetDrawTarget(scene.get());
+				pgengine->FillRect(0, 0, width, height, olc::Pixel(255, 255, 255));
+			} else {
+				pgengine->Clear(olc::Pixel(255, 255, 255));
+			}
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			engine.renderObjects(frame.objects, width, height, (*pgengine));
+			renderScale.update(chrono::duration<float>(chrono::steady_clock::now()-start).count());
+
+			if (scaled) {
+				pgengine->SetDrawTarget(screen);
+				pgengine->DrawStretchedSprite(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight(), scene.get(), 0, 0, width, height, pgengine->bilinearUpscale);
+			}
+
+			/* drawing 2d */
+			pgengine->DrawString(10, 10+15*0, frame.health.c_str(), olc::Pixel(0, 0, 0));
+			pgengine->DrawString(10, 10+15*1, frame.bullets.c_str(), olc::Pixel(0, 0, 0));
+			pgengine->DrawString(10, 10+15*2, frame.score.c_str(), olc::Pixel(0, 0, 0));
+
+			/* profiler overlay */
+			if (pgengine->profiling) {
+				int line = 0;
+
+				pgengine->DrawString(350, 10+15*line++, frame.allocations.c_str(), olc::Pixel(0, 0, 255));
+				pgengine->DrawString(350, 10+15*line++, frame.allocatedBytes.c_str(), olc::Pixel(0, 0, 255));
+
+				for (int tag = 0; tag < AllocationSnapshot::maxTags; tag++) {
+					if (Allocations::names[tag] != nullptr) {
+						pgengine->DrawString(350, 10+15*line++, frame.tagAllocations[tag].c_str(), olc::Pixel(0, 0, 255));
+					}
+				}
+
+				culled.set(engine.culledObjects);
+				overdraw.set(engine.overdraw);
+				savedOverdraw.set(engine.savedOverdraw);
+				pgengine->DrawString(350, 10+15*line++, culled.c_str(), olc::Pixel(0, 0, 255));
+				pgengine->DrawString(350, 10+15*line++, overdraw.c_str(), olc::Pixel(0, 0, 255));
+				pgengine->DrawString(350, 10+15*line++, savedOverdraw.c_str(), olc::Pixel(0, 0, 255));
+
+				if (renderScale.budget > 0) {
+					scale.set((int) (renderScale.scale*100));
+					pgengine->DrawString(350, 10+15*line++, scale.c_str(), olc::Pixel(0, 0, 255));
+				}
+			}
+		}
+
 		void onEnd() {
 			pgengine->lastScore = player.score;
+
+			if (pgengine->recordPath != "") {
+				if (log.save(pgengine->recordPath)) {
+					cout << "recorded " << log.inputs.size() << " ticks to " << pgengine->recordPath << endl;
+				} else {
+					cout << "could not write " << pgengine->recordPath << endl;
+				}
+			}
 		}
 };
 
@@ -1143,28 +3113,45 @@ class GameOverState : public State {
 		StateManager* stateManager;
 		Demo* pgengine;
 
+		bool redraw;
+
+		// lastScore as it was when each frame slot was filled
+		vector<HudText> scores;
+
 		GameOverState(StateManager* stateManager, Demo* pgengine): stateManager(stateManager), pgengine(pgengine) {
-			name = "GameOver";
+			id = GAME_OVER;
 		}
 
 		void onStart() {
-			
+			pgengine->SetRetainedMode(true);
+			redraw = true;
+
+			scores.resize(pgengine->GetFrameSlots(), HudText("Score: "));
 		}
 
 		bool onUpdate(float elapsedTime) {
-			pgengine->FillRect(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight(), olc::Pixel(0, 0, 0));
+			scores[pgengine->GetFrameSlot()].set(pgengine->lastScore);
 
-			pgengine->DrawString(40, 40, "Game Over", olc::Pixel(255, 255, 255), 2);
-			pgengine->DrawString(40, 75, "Score: "+to_string(pgengine->lastScore), olc::Pixel(255, 255, 255));
-			pgengine->DrawString(40, 90, "Press [ SPACE ] to go back to menu", olc::Pixel(255, 255, 255));
+			if (redraw) {
+				pgengine->MarkDirty(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight());
+				redraw = false;
+			}
 
 			if (pgengine->GetKey(olc::Key::SPACE).bPressed) {
-				stateManager->setState("Menu");
+				stateManager->setState(MENU);
 			}
 
 			return true;
 		}
 
+		void onRender(int slot) {
+			pgengine->Clear(olc::Pixel(0, 0, 0));
+
+			pgengine->DrawString(40, 40, "Game Over", olc::Pixel(255, 255, 255), 2);
+			pgengine->DrawString(40, 75, scores[slot].c_str(), olc::Pixel(255, 255, 255));
+			pgengine->DrawString(40, 90, "Press [ SPACE ] to go back to menu", olc::Pixel(255, 255, 255));
+		}
+
 		void onEnd() {
 			
 		}
@@ -1175,14 +3162,32 @@ class HelpState : public State {
 		StateManager* stateManager;
 		Demo* pgengine;
 
+		bool redraw;
+
 		HelpState(StateManager* stateManager, Demo* pgengine): stateManager(stateManager), pgengine(pgengine) {
-			name = "Help";
+			id = HELP;
 		}
 
-		void onStart() {}
+		void onStart() {
+			pgengine->SetRetainedMode(true);
+			redraw = true;
+		}
 
 		bool onUpdate(float elapsedTime) {
-			pgengine->FillRect(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight(), olc::Pixel(255, 255, 255));
+			if (redraw) {
+				pgengine->MarkDirty(0, 0, pgengine->ScreenWidth(), pgengine->ScreenHeight());
+				redraw = false;
+			}
+
+			if (pgengine->GetKey(olc::Key::ESCAPE).bPressed) {
+				stateManager->setState(MENU);
+			}
+
+			return true;
+		}
+
+		void onRender(int slot) {
+			pgengine->Clear(olc::Pixel(255, 255, 255));
 
 			int x1 = 460-46*8;
 			int x2 = 460-21*8;
@@ -1190,12 +3195,6 @@ class HelpState : public State {
 			pgengine->DrawString(x1, 40+15*0, "Use left and right arrow to control space ship", olc::Pixel(0, 0, 0));
 			pgengine->DrawString(x2, 40+15*1, "Use up arrow to shoot", olc::Pixel(0, 0, 0));
 			pgengine->DrawString(x3, 460-15*1, "Press [ ESC ] to go back to menu", olc::Pixel(0, 0, 0));
-
-			if (pgengine->GetKey(olc::Key::ESCAPE).bPressed) {
-				stateManager->setState("Menu");
-			}
-
-			return true;
 		}
 
 		void onEnd() {}
@@ -1205,13 +3204,28 @@ class HelpState : public State {
 
 Demo::Demo() {
 	sAppName = "ClickerinoCpp";
+
+	seed = 0;
+
+	replaying = false;
+
+	profiling = false;
+	depthPrepass = false;
+	raster = Engine::bestRaster();
+	renderBudget = 0;
+	bilinearUpscale = false;
+	indexed = false;
 }
 
 bool Demo::OnUserCreate() {
-	olc::Sprite* putinSprite = new olc::Sprite("Sprites/putinASCII.png");
+	// decoded once, later starts read the uncompressed .spr copy next to the png
+	olc::Sprite* putinSprite = new olc::Sprite();
+	putinSprite->LoadFromFile("Sprites/putinASCII.png", nullptr, true);
 	sprites.insert(make_pair("putin", putinSprite));
 
-	stateManager = StateManager();
+	random = Random(seed);
+
+	stateManager.setFrameSlots(GetFrameSlots());
 
 	State* gameState = new GameState((&stateManager), this);
 	stateManager.addState(gameState);
@@ -1227,22 +3241,173 @@ bool Demo::OnUserCreate() {
 
 	lastScore = -1;
 
-	stateManager.setState("Menu");
+	if (replayPath != "") {
+		if (!replay.load(replayPath)) {
+			cout << "could not read replay " << replayPath << endl;
+
+			return false;
+		}
+
+		replaying = true;
+
+		stateManager.prepareState(GAME);
+		stateManager.setState(GAME);
+	} else {
+		stateManager.setState(MENU);
+	}
 
 	return true;
 }
 
 bool Demo::OnUserUpdate(float elpasedTime) {
-	return stateManager.update(elpasedTime);
+	return stateManager.update(elpasedTime, GetFrameSlot());
+}
+
+bool Demo::OnUserRender(uint32_t frameSlot) {
+	stateManager.render(frameSlot);
+
+	return true;
 }
 
 
 
-int main() {
-	srand(time(NULL));
+int main(int argc, char* argv[]) {
+	uint64_t seed = time(NULL);
+	string recordPath = "";
+	string replayPath = "";
+	float fps = 60;
+	float idleFps = 15;
+	bool uncapped = false;
+	bool fpsGiven = false;
+	int backBuffers = 0;
+	olc::PixelGameEngine::Backend backend = olc::PixelGameEngine::OPENGL;
+	string framesPath = "";
+	bool profiling = false;
+	bool depthPrepass = false;
+	Engine::Raster raster = Engine::bestRaster();
+	int jobWorkers = -1;
+	float renderBudget = 0;
+	bool bilinearUpscale = false;
+	bool indexed = false;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+
+		if (arg == "--seed" && i+1 < argc) {
+			seed = stoull(argv[++i]);
+		} else if (arg == "--record" && i+1 < argc) {
+			recordPath = argv[++i];
+		} else if (arg == "--replay" && i+1 < argc) {
+			replayPath = argv[++i];
+		} else if (arg == "--fps" && i+1 < argc) {
+			fps = stof(argv[++i]);
+			fpsGiven = true;
+		} else if (arg == "--idle-fps" && i+1 < argc) {
+			idleFps = stof(argv[++i]);
+		} else if (arg == "--uncapped") {
+			uncapped = true;
+		} else if (arg == "--pipeline" && i+1 < argc) {
+			backBuffers = stoi(argv[++i]);
+		} else if (arg == "--backend" && i+1 < argc) {
+			string name = argv[++i];
+
+			if (name == "gl") {
+				backend = olc::PixelGameEngine::OPENGL;
+			} else if (name == "xshm") {
+				backend = olc::PixelGameEngine::XSHM;
+			} else if (name == "headless") {
+				backend = olc::PixelGameEngine::HEADLESS;
+			} else {
+				cout << "unknown backend " << name << ", use gl, xshm or headless" << endl;
+
+				return 1;
+			}
+		} else if (arg == "--frames" && i+1 < argc) {
+			framesPath = argv[++i];
+		} else if (arg == "--profile") {
+			profiling = true;
+		} else if (arg == "--depth-prepass") {
+			depthPrepass = true;
+		} else if (arg == "--raster" && i+1 < argc) {
+			string name = argv[++i];
+
+			if (name == "scalar") {
+				raster = Engine::RASTER_SCALAR;
+			} else if (name == "sse2") {
+				raster = Engine::RASTER_SSE2;
+			} else if (name == "avx2") {
+				raster = Engine::RASTER_AVX2;
+			} else {
+				cout << "unknown rasterizer " << name << ", use scalar, sse2 or avx2" << endl;
+
+				return 1;
+			}
+		} else if (arg == "--jobs" && i+1 < argc) {
+			jobWorkers = stoi(argv[++i]);
+		} else if (arg == "--render-budget" && i+1 < argc) {
+			renderBudget = stof(argv[++i])/1000;
+		} else if (arg == "--upscale" && i+1 < argc) {
+			string name = argv[++i];
+
+			if (name == "nearest") {
+				bilinearUpscale = false;
+			} else if (name == "bilinear") {
+				bilinearUpscale = true;
+			} else {
+				cout << "unknown upscale " << name << ", use nearest or bilinear" << endl;
+
+				return 1;
+			}
+		} else if (arg == "--indexed") {
+			indexed = true;
+		}
+	}
+
+	// without a window there is no input, a game would never start
+	if (backend == olc::PixelGameEngine::HEADLESS && replayPath == "") {
+		cout << "the headless backend has no input, use it with --replay" << endl;
+
+		return 1;
+	}
+
+	// printed so that any run can be reproduced with --seed
+	cout << "seed: " << seed << endl;
 
 	Demo demo;
-	if (demo.Construct(500, 500, 1, 1)) {
+	demo.seed = seed;
+	demo.recordPath = recordPath;
+	demo.replayPath = replayPath;
+	demo.profiling = profiling;
+	demo.depthPrepass = depthPrepass;
+	demo.raster = raster;
+	demo.SetJobWorkers(jobWorkers);
+	demo.renderBudget = renderBudget;
+	demo.bilinearUpscale = bilinearUpscale;
+	demo.indexed = indexed;
+
+	if (profiling) {
+		Allocations::names[ALLOCATION_SIMULATION] = "simulation";
+		Allocations::names[ALLOCATION_RENDER] = "render";
+		Allocations::names[ALLOCATION_LOADING] = "loading";
+		Allocations::enabled = true;
+	}
+
+	// replays are benchmarks, they run as fast as possible unless asked otherwise
+	if (replayPath != "" && !fpsGiven) {
+		uncapped = true;
+	}
+
+	if (uncapped) {
+		demo.SetFramePacing(olc::PixelGameEngine::UNCAPPED);
+	} else {
+		demo.SetFramePacing(olc::PixelGameEngine::ADAPTIVE, fps, idleFps);
+	}
+	if (demo.Construct(500, 500, 1, 1, false, backend, framesPath)) {
+		// back buffers are screen sized, so this has to wait for Construct
+		if (backBuffers > 0) {
+			demo.SetPipelined(true, backBuffers);
+		}
+
         demo.Start();
     }
 
@@ -90,7 +90,7 @@
 	You will need a modern C++ compiler, so update yours!
 	To compile use the command:
 
-	g++ -o YourProgName YourSource.cpp -lX11 -lGL -lpthread -lpng
+	g++ -o YourProgName YourSource.cpp -lX11 -lXext -lGL -lpthread -lpng
 
 	On some Linux configurations, the frame rate is locked to the refresh
 	rate of the monitor. This engine tries to unlock it but may not be
@@ -194,20 +194,115 @@
 	#include <GL/gl.h>
 	typedef BOOL(WINAPI wglSwapInterval_t) (int interval);
 	static wglSwapInterval_t *wglSwapInterval;
+	typedef HGLRC(WINAPI wglCreateContextAttribsARB_t) (HDC hDC, HGLRC hShareContext, const int *attribList);
+	#define WGL_CONTEXT_MAJOR_VERSION_ARB		0x2091
+	#define WGL_CONTEXT_MINOR_VERSION_ARB		0x2092
+	#define WGL_CONTEXT_PROFILE_MASK_ARB		0x9126
+	#define WGL_CONTEXT_CORE_PROFILE_BIT_ARB	0x00000001
+	#define olc_GetGLProc(name) wglGetProcAddress(name)
 #else
 	#include <GL/gl.h>
 	#include <GL/glx.h>
 	#include <X11/X.h>
 	#include <X11/Xlib.h>
+	#include <X11/Xutil.h>
+	#include <X11/extensions/XShm.h>
+	#include <sys/ipc.h>
+	#include <sys/shm.h>
 	#include <png.h>
 	typedef int(glSwapInterval_t) (Display *dpy, GLXDrawable drawable, int interval);
 	static glSwapInterval_t *glSwapIntervalEXT;
+	typedef GLXContext(glXCreateContextAttribsARB_t) (Display *dpy, GLXFBConfig config, GLXContext share_context, Bool direct, const int *attrib_list);
+#ifndef GLX_CONTEXT_MAJOR_VERSION_ARB
+	#define GLX_CONTEXT_MAJOR_VERSION_ARB		0x2091
+	#define GLX_CONTEXT_MINOR_VERSION_ARB		0x2092
 #endif
+#ifndef GLX_CONTEXT_PROFILE_MASK_ARB
+	#define GLX_CONTEXT_PROFILE_MASK_ARB		0x9126
+	#define GLX_CONTEXT_CORE_PROFILE_BIT_ARB	0x00000001
+#endif
+	#define olc_GetGLProc(name) glXGetProcAddress((const unsigned char*)name)
+#endif
+
+	// OpenGL 1.5 - 3.3 functionality used for presenting, loaded at runtime
+	// as the system headers (Windows) only go up to OpenGL 1.1
+#ifndef APIENTRY
+	#define APIENTRY
+#endif
+#ifndef GL_VERSION_1_5
+	typedef ptrdiff_t GLsizeiptr;
+	typedef ptrdiff_t GLintptr;
+#endif
+#ifndef GL_VERSION_2_0
+	typedef char GLchar;
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+	#define GL_PIXEL_UNPACK_BUFFER				0x88EC
+#endif
+#ifndef GL_STREAM_DRAW
+	#define GL_STREAM_DRAW						0x88E0
+#endif
+#ifndef GL_MAP_WRITE_BIT
+	#define GL_MAP_WRITE_BIT					0x0002
+	#define GL_MAP_INVALIDATE_BUFFER_BIT		0x0008
+#endif
+#ifndef GL_VERTEX_SHADER
+	#define GL_FRAGMENT_SHADER					0x8B30
+	#define GL_VERTEX_SHADER					0x8B31
+	#define GL_COMPILE_STATUS					0x8B81
+	#define GL_LINK_STATUS						0x8B82
+#endif
+	typedef void(APIENTRY glGenBuffers_t) (GLsizei n, GLuint *buffers);
+	typedef void(APIENTRY glDeleteBuffers_t) (GLsizei n, const GLuint *buffers);
+	typedef void(APIENTRY glBindBuffer_t) (GLenum target, GLuint buffer);
+	typedef void(APIENTRY glBufferData_t) (GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+	typedef void*(APIENTRY glMapBufferRange_t) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+	typedef GLboolean(APIENTRY glUnmapBuffer_t) (GLenum target);
+	typedef GLuint(APIENTRY glCreateShader_t) (GLenum type);
+	typedef void(APIENTRY glShaderSource_t) (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length);
+	typedef void(APIENTRY glCompileShader_t) (GLuint shader);
+	typedef void(APIENTRY glGetShaderiv_t) (GLuint shader, GLenum pname, GLint *params);
+	typedef void(APIENTRY glDeleteShader_t) (GLuint shader);
+	typedef GLuint(APIENTRY glCreateProgram_t) (void);
+	typedef void(APIENTRY glAttachShader_t) (GLuint program, GLuint shader);
+	typedef void(APIENTRY glLinkProgram_t) (GLuint program);
+	typedef void(APIENTRY glGetProgramiv_t) (GLuint program, GLenum pname, GLint *params);
+	typedef void(APIENTRY glUseProgram_t) (GLuint program);
+	typedef void(APIENTRY glDeleteProgram_t) (GLuint program);
+	typedef GLint(APIENTRY glGetUniformLocation_t) (GLuint program, const GLchar *name);
+	typedef void(APIENTRY glUniform2f_t) (GLint location, GLfloat v0, GLfloat v1);
+	typedef void(APIENTRY glGenVertexArrays_t) (GLsizei n, GLuint *arrays);
+	typedef void(APIENTRY glBindVertexArray_t) (GLuint array);
+	typedef void(APIENTRY glDeleteVertexArrays_t) (GLsizei n, const GLuint *arrays);
+	static glGenBuffers_t *olc_glGenBuffers;
+	static glDeleteBuffers_t *olc_glDeleteBuffers;
+	static glBindBuffer_t *olc_glBindBuffer;
+	static glBufferData_t *olc_glBufferData;
+	static glMapBufferRange_t *olc_glMapBufferRange;
+	static glUnmapBuffer_t *olc_glUnmapBuffer;
+	static glCreateShader_t *olc_glCreateShader;
+	static glShaderSource_t *olc_glShaderSource;
+	static glCompileShader_t *olc_glCompileShader;
+	static glGetShaderiv_t *olc_glGetShaderiv;
+	static glDeleteShader_t *olc_glDeleteShader;
+	static glCreateProgram_t *olc_glCreateProgram;
+	static glAttachShader_t *olc_glAttachShader;
+	static glLinkProgram_t *olc_glLinkProgram;
+	static glGetProgramiv_t *olc_glGetProgramiv;
+	static glUseProgram_t *olc_glUseProgram;
+	static glDeleteProgram_t *olc_glDeleteProgram;
+	static glGetUniformLocation_t *olc_glGetUniformLocation;
+	static glUniform2f_t *olc_glUniform2f;
+	static glGenVertexArrays_t *olc_glGenVertexArrays;
+	static glBindVertexArray_t *olc_glBindVertexArray;
+	static glDeleteVertexArrays_t *olc_glDeleteVertexArrays;
 
 
 // Standard includes
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <sys/stat.h>
 #include <string>
 #include <iostream>
 #include <streambuf>
@@ -217,11 +312,18 @@
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <fstream>
 #include <map>
 #include <functional>
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define OLC_SSE2
+#endif
+
 #undef min
 #undef max
 
@@ -352,10 +454,15 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		~Sprite();
 
 	public:
-		olc::rcode LoadFromFile(std::string sImageFile, olc::ResourcePack *pack = nullptr);
+		// With bUseCache the decoded image is also saved next to sImageFile as
+		// sImageFile + ".spr", and loaded from there while it is newer than the image
+		olc::rcode LoadFromFile(std::string sImageFile, olc::ResourcePack *pack = nullptr, bool bUseCache = false);
 		olc::rcode LoadFromPGESprFile(std::string sImageFile, olc::ResourcePack *pack = nullptr);
 		olc::rcode SaveToPGESprFile(std::string sImageFile);
 
+	private:
+		olc::rcode LoadFromImageFile(std::string sImageFile);
+
 	public:
 		int32_t width = 0;
 		int32_t height = 0;
@@ -369,6 +476,8 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		Pixel Sample(float x, float y);
 		Pixel SampleBL(float u, float v);
 		Pixel* GetData();
+		// Returns the first pixel of row y, or nullptr if y is outside the sprite
+		Pixel* GetRow(int32_t y);
 	
 	private:
 		Pixel *pColData = nullptr;
@@ -397,6 +506,102 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 	};
 
 
+	//=============================================================
+
+	// Lock free queue for handing values from exactly one producer
+	// thread to exactly one consumer thread
+	template <class T, uint32_t N>
+	class SPSCQueue
+	{
+	public:
+		bool push(const T &v)
+		{
+			uint32_t t = nTail.load(std::memory_order_relaxed);
+			if (t - nHead.load(std::memory_order_acquire) == N) return false;
+			data[t % N] = v;
+			nTail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool pop(T &v)
+		{
+			uint32_t h = nHead.load(std::memory_order_relaxed);
+			if (h == nTail.load(std::memory_order_acquire)) return false;
+			v = data[h % N];
+			nHead.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		T data[N];
+		std::atomic<uint32_t> nHead{ 0 };
+		std::atomic<uint32_t> nTail{ 0 };
+	};
+
+	//=============================================================
+
+	// Work stealing job scheduler. Every worker thread owns a deque, runs
+	// its newest jobs first and steals the oldest jobs of the others when
+	// it runs dry. Workers waiting for a job run other jobs meanwhile, so
+	// jobs may wait for jobs, other threads only ever run the job they wait
+	// for, so that a frame is never held up by someone else's work. Without
+	// workers, or once stopped, every job runs on the thread that made it
+	// ready, in submission order, which keeps runs deterministic
+	class JobSystem
+	{
+	public:
+		struct sJob
+		{
+			std::function<void()> func;
+			std::atomic<int32_t> nPending{ 1 };	// Unfinished dependencies + 1 until submitted
+			std::atomic<bool> bQueued{ false };
+			std::atomic<bool> bClaimed{ false };	// Whoever sets it runs the job, queues skip it
+			std::atomic<bool> bDone{ false };
+			std::mutex mux;
+			std::vector<std::shared_ptr<sJob>> vDependents;
+		};
+		typedef std::shared_ptr<sJob> Job;
+
+	public:
+		~JobSystem();
+		// nWorkers < 0 starts one worker per hardware thread besides the
+		// calling one, 0 starts none. Not while jobs are in use
+		void Start(int32_t nWorkers = -1);
+		// Runs what is still queued and ends the workers, jobs submitted
+		// later run on the submitting thread
+		void Stop();
+		uint32_t GetWorkerCount();
+		// Runs func once every job in vDependencies is done
+		Job Submit(std::function<void()> func, const std::vector<Job> &vDependencies = {});
+		// Returns when job is done
+		void Wait(const Job &job);
+		// Calls func(nBegin, nEnd) on ranges of nGrain items covering
+		// 0 to nCount and returns when all of them are done
+		void ParallelFor(uint32_t nCount, uint32_t nGrain, const std::function<void(uint32_t, uint32_t)> &func);
+
+	private:
+		struct sWorker
+		{
+			std::deque<Job> dqJobs;
+			std::mutex mux;
+		};
+		std::vector<std::unique_ptr<sWorker>> vWorkers;
+		std::vector<std::thread> vThreads;
+		std::atomic<bool> bRunning{ false };
+		std::atomic<uint32_t> nNextWorker{ 0 };
+		std::atomic<uint32_t> nQueued{ 0 };
+		std::mutex muxSleep;
+		std::condition_variable cvSleep;
+
+		static thread_local JobSystem *pCurrentSystem;
+		static thread_local int32_t nCurrentWorker;
+
+		void olc_Ready(const Job &job);
+		bool olc_Run(const Job &job);
+		bool olc_RunOne();
+		void olc_WorkerThread(int32_t nWorker);
+	};
+
 	//=============================================================
 
 	class PixelGameEngine
@@ -405,7 +610,15 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		PixelGameEngine();
 
 	public:
-		olc::rcode	Construct(uint32_t screen_w, uint32_t screen_h, uint32_t pixel_w, uint32_t pixel_h, bool full_screen = false);
+		// How finished frames get to the screen
+		// OPENGL   = Upload to a texture and draw it, needs a working OpenGL driver
+		// XSHM     = (Linux) Blit through X11 MIT-SHM shared memory, no OpenGL at all
+		// HEADLESS = No window or input, frames are appended to sOutputFile as raw
+		//            RGBA when one is given and dropped otherwise
+		enum Backend { OPENGL, XSHM, HEADLESS };
+
+	public:
+		olc::rcode	Construct(uint32_t screen_w, uint32_t screen_h, uint32_t pixel_w, uint32_t pixel_h, bool full_screen = false, Backend backend = OPENGL, const std::string &sOutputFile = "");
 		olc::rcode	Start();
 
 	public: // Override Interfaces
@@ -413,6 +626,10 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		virtual bool OnUserCreate();
 		// Called every frame, and provides you with a time per frame value
 		virtual bool OnUserUpdate(float fElapsedTime);
+		// Called after OnUserUpdate for every frame that changes the screen, draw
+		// here from the data OnUserUpdate left in nFrameSlot. When pipelined this
+		// runs on its own thread, so OnUserUpdate must not draw at all
+		virtual bool OnUserRender(uint32_t nFrameSlot);
 		// Called once on application termination, so you can be a clean coder
 		virtual bool OnUserDestroy();
 
@@ -461,6 +678,9 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 
 		// Draws a single Pixel
 		virtual bool Draw(int32_t x, int32_t y, Pixel p = olc::WHITE);
+		// Draws the pixels x1 to x2 (inclusive) of row y. If a mask is given, only
+		// pixels with a non zero mask entry are drawn, mask[0] belongs to x1
+		void DrawSpan(int32_t x1, int32_t x2, int32_t y, Pixel p = olc::WHITE, const uint8_t *mask = nullptr);
 		// Draws a line from (x1,y1) to (x2,y2)
 		void DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p = olc::WHITE, uint32_t pattern = 0xFFFFFFFF);
 		// Draws a circle located at (x,y) with radius
@@ -480,11 +700,57 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		// Draws an area of a sprite at location (x,y), where the
 		// selected area is (ox,oy) to (ox+w,oy+h)
 		void DrawPartialSprite(int32_t x, int32_t y, Sprite *sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint32_t scale = 1);
+		// Stretches the area (ox,oy) to (ox+ow,oy+oh) of a sprite over (x,y) to (x+w,y+h),
+		// taking the nearest pixel or, with bBilinear, blending the four nearest
+		void DrawStretchedSprite(int32_t x, int32_t y, int32_t w, int32_t h, Sprite *sprite, int32_t ox, int32_t oy, int32_t ow, int32_t oh, bool bBilinear = false);
 		// Draws a single line of text
-		void DrawString(int32_t x, int32_t y, std::string sText, Pixel col = olc::WHITE, uint32_t scale = 1);
+		void DrawString(int32_t x, int32_t y, const std::string &sText, Pixel col = olc::WHITE, uint32_t scale = 1);
+		// Same for text in a caller owned buffer, nothing is allocated unless the
+		// text was not drawn recently
+		void DrawString(int32_t x, int32_t y, const char *sText, Pixel col = olc::WHITE, uint32_t scale = 1);
 		// Clears entire draw target to Pixel
 		void Clear(Pixel p);
 
+	public: // Retained Mode
+		// When enabled, the screen is no longer uploaded every frame. Only areas
+		// marked dirty are sent to the screen, and frames with nothing marked
+		// are not presented at all, so static screens only need drawing once
+		void SetRetainedMode(bool bRetained);
+		bool IsRetainedMode();
+		// Marks the area (x,y) to (x+w,y+h) of the screen as changed this frame
+		void MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h);
+		// Returns true if the current frame will not change the screen
+		bool IsFrameStatic();
+
+	public: // Frame Pacing
+		// UNCAPPED = Run as fast as possible, use for benchmarking
+		// FIXED    = Limit to fTargetFps
+		// ADAPTIVE = Limit to fTargetFps, drop to fIdleFps while frames are static
+		enum Pacing { UNCAPPED, FIXED, ADAPTIVE };
+		void SetFramePacing(Pacing mode, float fTargetFps = 60.0f, float fIdleFps = 15.0f);
+
+	public: // Pipelining
+		// Splits frames over three threads: OnUserUpdate on the game thread,
+		// OnUserRender on a render thread drawing into one of nBackBuffers (2 or 3)
+		// back buffers, and presentation on the OpenGL thread. Throughput rises
+		// to that of the slowest stage at the cost of nBackBuffers - 1 frames
+		// of latency. Must be called before Start()
+		void SetPipelined(bool bPipelined, uint32_t nBackBuffers = 2);
+		// Number of frames that can be in flight at once, so the number of
+		// copies of per frame data OnUserUpdate hands to OnUserRender
+		uint32_t GetFrameSlots();
+		// The copy of per frame data the current OnUserUpdate should fill
+		uint32_t GetFrameSlot();
+
+	public: // Jobs
+		// Worker threads for GetJobs(), -1 (default) sizes them to the
+		// hardware and 0 runs all jobs on the submitting thread. Must be
+		// called before Construct()
+		void SetJobWorkers(int32_t nWorkers);
+		// Scheduler for work the application wants spread over all cores,
+		// started by Construct()
+		JobSystem &GetJobs();
+
 	public: // Branding
 		std::string sAppName;
 
@@ -519,8 +785,60 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		float		fFrameTimer = 1.0f;
 		int			nFrameCount = 0;
 		Sprite		*fontSprite = nullptr;
+		uint8_t		nFontGlyphs[96][8];	// Rows of each glyph as bits, bit 0 is the leftmost pixel
 		std::function<olc::Pixel(const int x, const int y, const olc::Pixel&, const olc::Pixel&)> funcPixelMode;
 
+		struct sRect { int32_t x, y, w, h; };
+		bool		bRetainedMode = false;
+		bool		bFullUpload = true;
+		std::vector<sRect> vDirtyRects;
+		Pacing		nPacing = UNCAPPED;
+		float		fPacingTargetFps = 60.0f;
+		float		fPacingIdleFps = 15.0f;
+		std::chrono::steady_clock::duration tSleepSlack = std::chrono::milliseconds(1);
+
+		// Everything presenting needs besides the pixels, the window and
+		// viewport are copied in as they were when the frame was updated,
+		// as the game thread changes them while earlier frames are presented
+		struct sFrame { std::vector<sRect> vDirtyRects; bool bFull; sRect rView; int32_t nWindowWidth, nWindowHeight; };
+		// A string expanded into rows of bits, one per pixel of its bounding box
+		struct sTextLayout
+		{
+			std::string sText;
+			uint32_t nScale;
+			int32_t nWidth, nHeight, nRowBytes;
+			std::vector<uint8_t> vBits;
+			uint32_t nLastUse;
+		};
+		std::vector<sTextLayout> vTextCache;
+		uint32_t	nTextUse = 0;
+		// Source columns of the destination columns of a stretch, kept to
+		// not allocate every frame
+		struct sStretchColumn { int32_t x0, x1; uint32_t nFrac; };
+		std::vector<sStretchColumn> vStretchColumns;
+		std::vector<uint32_t> vStretchRows;
+		const sTextLayout &olc_LayoutString(const char *sText, size_t nLength, uint32_t scale);
+		void olc_DrawText(int32_t x, int32_t y, const char *sText, size_t nLength, Pixel col, uint32_t scale);
+
+		bool		bPipelined = false;
+		uint32_t	nFrameSlots = 1;
+		uint32_t	nFrameSlot = 0;
+		std::vector<sFrame> vFrames;
+		std::vector<Sprite*> vBackBuffers;
+		SPSCQueue<uint32_t, 8> qRender;		// Game -> render, frame slots
+		SPSCQueue<uint32_t, 8> qPresent;	// Render -> present, frame slot | back buffer << 16
+		SPSCQueue<uint32_t, 8> qFreeBuffers;// Present -> render, back buffers
+		std::atomic<uint32_t> nFramesSubmitted{ 0 };
+		std::atomic<uint32_t> nFramesRetired{ 0 };
+		std::atomic<bool> bPipelineActive{ false };
+
+		int32_t		nJobWorkers = -1;
+		JobSystem	jobs;
+
+		Backend		nBackend = OPENGL;
+		std::string	sHeadlessFile;
+		FILE		*pHeadlessFile = nullptr;
+
 		static std::map<uint16_t, uint8_t> mapKeys;
 		bool		pKeyNewState[256]{ 0 };
 		bool		pKeyOldState[256]{ 0 };
@@ -538,8 +856,21 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		GLXContext	glRenderContext = nullptr;
 #endif
 		GLuint		glBuffer;
+		GLuint		glPixelBuffers[2] = { 0, 0 };
+		int			nPixelBuffer = 0;
+		GLuint		glScreenProgram = 0;
+		GLuint		glScreenVertexArray = 0;
+		GLint		glOffsetUniform = -1;
+		bool		bGLCoreProfile = false;
+		bool		bGLLegacyOnly = false;	// Set once the core profile path has failed
+		bool		bGLStreaming = false;
+		bool		bBackendReady = false;
 
 		void		EngineThread();
+		void		RenderThread();
+		void		PresentThread();
+		void		olc_WaitUntil(std::chrono::steady_clock::time_point tp);
+		void		olc_PipelineWait(std::function<bool()> ready);
 
 		// If anything sets this flag to false, the engine
 		// "should" shut down gracefully
@@ -551,6 +882,21 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		void olc_UpdateWindowSize(int32_t x, int32_t y);
 		void olc_UpdateViewport();
 		bool olc_OpenGLCreate();
+		void olc_OpenGLDestroy();
+		bool olc_LoadGLFunctions();
+
+		// Presentation of finished frames, the Backend functions pick
+		// between OpenGL and the software backends. Create returns false
+		// when nothing can be presented, the others do nothing then
+		bool olc_BackendCreate();
+		void olc_BackendPresent(Sprite *pFrame, const sFrame &frame);
+		void olc_BackendDestroy();
+		bool olc_PresentCreate();
+		void olc_PresentFrame(Sprite *pFrame, const sFrame &frame);
+		void olc_PresentDestroy();
+		bool olc_SoftwarePresentCreate();
+		void olc_SoftwarePresentFrame(Sprite *pFrame, const sFrame &frame);
+		void olc_SoftwarePresentDestroy();
 		void olc_ConstructFontSheet();
 
 
@@ -569,6 +915,16 @@ namespace olc // All OneLoneCoder stuff will now exist in the "olc" namespace
 		Colormap                olc_ColourMap;
 		XSetWindowAttributes    olc_SetWindowAttribs;
 		Display*				olc_WindowCreate();
+
+		// Software presenting, frames are converted into olc_Image
+		GC						olc_GC;
+		XImage*					olc_Image = nullptr;
+		XShmSegmentInfo			olc_ShmInfo;
+		bool					bXShm = false;
+		bool					bDirectPixels = false;
+		int						nShiftR = 0;
+		int						nShiftG = 0;
+		int						nShiftB = 0;
 #endif
 
 	};
@@ -678,12 +1034,16 @@ namespace olc
 	{
 		if (pColData) delete[] pColData;
 
+		pColData = nullptr;
+
 		auto ReadData = [&](std::istream &is)
 		{
 			is.read((char*)&width, sizeof(int32_t));
 			is.read((char*)&height, sizeof(int32_t));
+			if (!is || width <= 0 || height <= 0) return false;
 			pColData = new Pixel[width * height];
 			is.read((char*)pColData, width * height * sizeof(uint32_t));
+			return !is.fail();
 		};
 
 		// These are essentially Memory Surfaces represented by olc::Sprite
@@ -692,11 +1052,8 @@ namespace olc
 		{
 			std::ifstream ifs;
 			ifs.open(sImageFile, std::ifstream::binary);
-			if (ifs.is_open())
-			{
-				ReadData(ifs);
+			if (ifs.is_open() && ReadData(ifs))
 				return olc::OK;
-			}
 			else
 				return olc::FAIL;
 		}
@@ -729,8 +1086,29 @@ namespace olc
 		return olc::FAIL;
 	}
 
-	olc::rcode Sprite::LoadFromFile(std::string sImageFile, olc::ResourcePack *pack)
+	olc::rcode Sprite::LoadFromFile(std::string sImageFile, olc::ResourcePack *pack, bool bUseCache)
+	{
+		// The cache only counts while it is newer than the image it came from
+		std::string sCacheFile = sImageFile + ".spr";
+		if (bUseCache)
+		{
+			struct stat stImage, stCache;
+			if (stat(sImageFile.c_str(), &stImage) == 0 && stat(sCacheFile.c_str(), &stCache) == 0 && stCache.st_mtime >= stImage.st_mtime)
+				if (LoadFromPGESprFile(sCacheFile) == olc::OK)
+					return olc::OK;
+		}
+
+		olc::rcode result = LoadFromImageFile(sImageFile);
+		if (result == olc::OK && bUseCache)
+			SaveToPGESprFile(sCacheFile);
+		return result;
+	}
+
+	olc::rcode Sprite::LoadFromImageFile(std::string sImageFile)
 	{
+		if (pColData) delete[] pColData;
+		pColData = nullptr;
+
 #ifdef _WIN32
 		// Use GDI+
 		std::wstring wsImageFile;
@@ -764,8 +1142,9 @@ namespace olc
 		////////////////////////////////////////////////////////////////////////////
 		// Use libpng, Thanks to Guillaume Cottenceau
 		// https://gist.github.com/niw/5963798
-		png_structp png;
-		png_infop info;
+		png_structp png = nullptr;
+		png_infop info = nullptr;
+		std::vector<png_bytep> vRows;
 
 		FILE *f = fopen(sImageFile.c_str(), "rb");
 		if (!f) return olc::NO_FILE;
@@ -783,7 +1162,6 @@ namespace olc
 
 		png_byte color_type;
 		png_byte bit_depth;
-		png_bytep *row_pointers;
 		width = png_get_image_width(png, info);
 		height = png_get_image_height(png, info);
 		color_type = png_get_color_type(png, info);
@@ -807,34 +1185,27 @@ namespace olc
 			png_set_gray_to_rgb(png);
 
 		png_read_update_info(png, info);
-		row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * height);
-		for (int y = 0; y < height; y++) {
-			row_pointers[y] = (png_byte*)malloc(png_get_rowbytes(png, info));
-		}
-		png_read_image(png, row_pointers);
-		////////////////////////////////////////////////////////////////////////////
 
-		// Create sprite array
+		// The transforms above always give 8 bit RGBA, which is exactly the
+		// layout of Pixel, so rows are decoded straight into the sprite
 		pColData = new Pixel[width * height];
-
-		// Iterate through image rows, converting into sprite format
+		vRows.resize(height);
 		for (int y = 0; y < height; y++)
-		{
-			png_bytep row = row_pointers[y];
-			for (int x = 0; x < width; x++)
-			{
-				png_bytep px = &(row[x * 4]);
-				SetPixel(x, y, Pixel(px[0], px[1], px[2], px[3]));
-			}
-		}
+			vRows[y] = (png_bytep)(pColData + y * width);
+		png_read_image(png, vRows.data());
+		png_read_end(png, nullptr);
+		////////////////////////////////////////////////////////////////////////////
 
+		png_destroy_read_struct(&png, &info, nullptr);
 		fclose(f);
 		return olc::OK;
 
 	fail_load:
+		if (png) png_destroy_read_struct(&png, info ? &info : nullptr, nullptr);
 		width = 0;
 		height = 0;
 		fclose(f);
+		if (pColData) delete[] pColData;
 		pColData = nullptr;
 		return olc::FAIL;
 #endif
@@ -908,6 +1279,14 @@ namespace olc
 
 	Pixel* Sprite::GetData() { return pColData; }
 
+	Pixel* Sprite::GetRow(int32_t y)
+	{
+		if (y >= 0 && y < height)
+			return pColData + y * width;
+		else
+			return nullptr;
+	}
+
 	//==========================================================
 
 	ResourcePack::ResourcePack()
@@ -1054,13 +1433,23 @@ namespace olc
 		olc::PGEX::pge = this;
 	}
 
-	olc::rcode PixelGameEngine::Construct(uint32_t screen_w, uint32_t screen_h, uint32_t pixel_w, uint32_t pixel_h, bool full_screen)
+	olc::rcode PixelGameEngine::Construct(uint32_t screen_w, uint32_t screen_h, uint32_t pixel_w, uint32_t pixel_h, bool full_screen, Backend backend, const std::string &sOutputFile)
 	{
 		nScreenWidth = screen_w;
 		nScreenHeight = screen_h;
 		nPixelWidth = pixel_w;
 		nPixelHeight = pixel_h;
 		bFullScreen = full_screen;
+		nBackend = backend;
+		sHeadlessFile = sOutputFile;
+
+#ifdef _WIN32
+		if (nBackend == XSHM)
+		{
+			printf("NOTE: XSHM is only available with X11, using OPENGL\n");
+			nBackend = OPENGL;
+		}
+#endif
 
 		fPixelX = 2.0f / (float)(nScreenWidth);
 		fPixelY = 2.0f / (float)(nScreenHeight);
@@ -1075,6 +1464,8 @@ namespace olc
 #endif
 #endif
 #endif
+		jobs.Start(nJobWorkers);
+
 		// Load the default font sheet
 		olc_ConstructFontSheet();
 		
@@ -1086,8 +1477,8 @@ namespace olc
 
 	olc::rcode PixelGameEngine::Start()
 	{
-		// Construct the window
-		if (!olc_WindowCreate())
+		// Construct the window, headless runs have none
+		if (nBackend != HEADLESS && !olc_WindowCreate())
 			return olc::FAIL;
 
 		// Load libraries required for PNG file interaction
@@ -1107,14 +1498,15 @@ namespace olc
 #ifdef _WIN32
 		// Handle Windows Message Loop
 		MSG msg;
-		while (GetMessage(&msg, NULL, 0, 0) > 0)
+		while (olc_hWnd && GetMessage(&msg, NULL, 0, 0) > 0)
 		{
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
 #endif
 
-		// Wait for thread to be exited
+		// Wait for thread to be exited, the jobs stay until the engine is
+		// destroyed, threads of the application may still be using them
 		t.join();
 		return olc::OK;
 	}
@@ -1223,6 +1615,36 @@ namespace olc
 		return false;
 	}
 
+	void PixelGameEngine::DrawSpan(int32_t x1, int32_t x2, int32_t y, Pixel p, const uint8_t *mask)
+	{
+		if (!pDrawTarget) return;
+
+		// Clip once for the whole span instead of once per pixel
+		int32_t sx = std::max(x1, 0);
+		int32_t ex = std::min(x2, pDrawTarget->width - 1);
+		Pixel *row = pDrawTarget->GetRow(y);
+		if (row == nullptr || sx > ex) return;
+
+		if (nPixelMode != Pixel::NORMAL)
+		{
+			for (int32_t x = sx; x <= ex; x++)
+				if (mask == nullptr || mask[x - x1]) Draw(x, y, p);
+			return;
+		}
+
+		if (mask == nullptr)
+			std::fill(row + sx, row + ex + 1, p);
+		else
+		{
+			for (int32_t x = sx; x <= ex; x++)
+				if (mask[x - x1]) row[x] = p;
+		}
+
+#ifdef OLC_DBG_OVERDRAW
+		olc::Sprite::nOverdrawCount += ex - sx + 1;
+#endif
+	}
+
 	void PixelGameEngine::SetSubPixelOffset(float ox, float oy)
 	{
 		fSubPixelOffsetX = ox * fPixelX;
@@ -1373,9 +1795,9 @@ namespace olc
 	void PixelGameEngine::Clear(Pixel p)
 	{
 		int pixels = GetDrawTargetWidth() * GetDrawTargetHeight();
-		Pixel* m = GetDrawTarget()->GetData();
-		for (int i = 0; i < pixels; i++)
-			m[i] = p;
+		uint32_t* m = (uint32_t*)GetDrawTarget()->GetData();
+		// Plain 32-bit stores, optimised builds turn this into wide vector stores
+		std::fill(m, m + pixels, p.n);
 #ifdef OLC_DBG_OVERDRAW
 		olc::Sprite::nOverdrawCount += pixels;
 #endif
@@ -1383,21 +1805,37 @@ namespace olc
 
 	void PixelGameEngine::FillRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p)
 	{			
+		int32_t nTargetWidth = GetDrawTargetWidth();
+		int32_t nTargetHeight = GetDrawTargetHeight();
 		int32_t x2 = x + w;
 		int32_t y2 = y + h;
 
 		if (x < 0) x = 0;
-		if (x >= (int32_t)nScreenWidth) x = (int32_t)nScreenWidth;
+		if (x >= nTargetWidth) x = nTargetWidth;
 		if (y < 0) y = 0;
-		if (y >= (int32_t)nScreenHeight) y = (int32_t)nScreenHeight;
+		if (y >= nTargetHeight) y = nTargetHeight;
 
 		if (x2 < 0) x2 = 0;
-		if (x2 >= (int32_t)nScreenWidth) x2 = (int32_t)nScreenWidth;
+		if (x2 >= nTargetWidth) x2 = nTargetWidth;
 		if (y2 < 0) y2 = 0;
-		if (y2 >= (int32_t)nScreenHeight) y2 = (int32_t)nScreenHeight;
+		if (y2 >= nTargetHeight) y2 = nTargetHeight;
+
+		if (x >= x2 || y >= y2) return;
 
-		for (int i = x; i < x2; i++)
+		if (nPixelMode == Pixel::NORMAL)
+		{
+			// No blending, so fill each clipped row directly
+			uint32_t* m = (uint32_t*)pDrawTarget->GetData();
 			for (int j = y; j < y2; j++)
+				std::fill(m + j * nTargetWidth + x, m + j * nTargetWidth + x2, p.n);
+#ifdef OLC_DBG_OVERDRAW
+			olc::Sprite::nOverdrawCount += (x2 - x) * (y2 - y);
+#endif
+			return;
+		}
+
+		for (int j = y; j < y2; j++)
+			for (int i = x; i < x2; i++)
 				Draw(i, j, p);
 	}
 
@@ -1588,43 +2026,296 @@ namespace olc
 		}
 	}
 
-	void PixelGameEngine::DrawString(int32_t x, int32_t y, std::string sText, Pixel col, uint32_t scale)
+	// Blends two pixels, nFrac of 256 parts of b, red with blue and green
+	// with alpha in one multiply each
+	static inline uint32_t olc_Lerp(uint32_t a, uint32_t b, uint32_t nFrac)
+	{
+		uint32_t rb = ((a & 0x00FF00FF) * (256 - nFrac) + (b & 0x00FF00FF) * nFrac) >> 8;
+		uint32_t ga = (((a >> 8) & 0x00FF00FF) * (256 - nFrac) + ((b >> 8) & 0x00FF00FF) * nFrac) >> 8;
+		return (rb & 0x00FF00FF) | ((ga & 0x00FF00FF) << 8);
+	}
+
+	// Maps destination i of n to the source area [o, o+on), in 8.8 fixed point
+	// through the pixel centres and clamped to the area
+	static inline void olc_StretchSample(int32_t i, int32_t n, int32_t o, int32_t on, int32_t &n0, int32_t &n1, uint32_t &nFrac)
+	{
+		int64_t s = (((int64_t)i * 2 + 1) * on * 256) / (2 * (int64_t)n) - 128;
+		s = std::max(s, (int64_t)0);
+		n0 = std::min((int32_t)(s >> 8), on - 1);
+		n1 = std::min(n0 + 1, on - 1);
+		nFrac = (uint32_t)(s & 255);
+		n0 += o;
+		n1 += o;
+	}
+
+	void PixelGameEngine::DrawStretchedSprite(int32_t x, int32_t y, int32_t w, int32_t h, Sprite *sprite, int32_t ox, int32_t oy, int32_t ow, int32_t oh, bool bBilinear)
+	{
+		if (sprite == nullptr || !pDrawTarget || w <= 0 || h <= 0)
+			return;
+
+		ow = std::min(ow, sprite->width - ox);
+		oh = std::min(oh, sprite->height - oy);
+		if (ow <= 0 || oh <= 0)
+			return;
+
+		// Only what lands on the draw target
+		int32_t sx = std::max(x, 0);
+		int32_t ex = std::min(x + w, pDrawTarget->width);
+		int32_t sy = std::max(y, 0);
+		int32_t ey = std::min(y + h, pDrawTarget->height);
+		if (sx >= ex || sy >= ey)
+			return;
+
+		// Columns repeat on every row, so they are worked out once
+		vStretchColumns.resize(ex - sx);
+		for (int32_t i = sx; i < ex; i++)
+		{
+			sStretchColumn &c = vStretchColumns[i - sx];
+			olc_StretchSample(i - x, w, ox, ow, c.x0, c.x1, c.nFrac);
+			if (!bBilinear && c.nFrac >= 128) c.x0 = c.x1;
+		}
+
+		if (nPixelMode != Pixel::NORMAL)
+		{
+			for (int32_t j = sy; j < ey; j++)
+			{
+				int32_t y0, y1;
+				uint32_t nFracY;
+				olc_StretchSample(j - y, h, oy, oh, y0, y1, nFracY);
+				Pixel *pSrc0 = sprite->GetRow(y0);
+				Pixel *pSrc1 = sprite->GetRow(y1);
+
+				for (int32_t i = sx; i < ex; i++)
+				{
+					const sStretchColumn &c = vStretchColumns[i - sx];
+					Pixel p;
+					if (bBilinear)
+						p.n = olc_Lerp(olc_Lerp(pSrc0[c.x0].n, pSrc0[c.x1].n, c.nFrac), olc_Lerp(pSrc1[c.x0].n, pSrc1[c.x1].n, c.nFrac), nFracY);
+					else
+						p = nFracY < 128 ? pSrc0[c.x0] : pSrc1[c.x0];
+					Draw(i, j, p);
+				}
+			}
+			return;
+		}
+
+		if (!bBilinear)
+		{
+			// Rows from the same source row are the same, so they are copied
+			int32_t nLastY = -1;
+			for (int32_t j = sy; j < ey; j++)
+			{
+				int32_t y0, y1;
+				uint32_t nFracY;
+				olc_StretchSample(j - y, h, oy, oh, y0, y1, nFracY);
+				if (nFracY >= 128) y0 = y1;
+
+				Pixel *pRow = pDrawTarget->GetRow(j);
+				if (y0 == nLastY)
+				{
+					std::copy(pRow - pDrawTarget->width + sx, pRow - pDrawTarget->width + ex, pRow + sx);
+					continue;
+				}
+
+				Pixel *pSrc = sprite->GetRow(y0);
+				for (int32_t i = sx; i < ex; i++)
+					pRow[i] = pSrc[vStretchColumns[i - sx].x0];
+				nLastY = y0;
+			}
+		}
+		else
+		{
+			// Source rows are stretched across once and kept while the
+			// destination rows between them are blended
+			vStretchRows.resize(2 * (ex - sx));
+			uint32_t *pRows[2] = { &vStretchRows[0], &vStretchRows[ex - sx] };
+			int32_t nRowY[2] = { -1, -1 };
+
+			auto stretchRow = [&](int32_t nSrcY, int32_t nSlot)
+			{
+				if (nRowY[nSlot] == nSrcY) return;
+				// Moving down a row, the lower row becomes the upper one
+				if (nSlot == 0 && nRowY[1] == nSrcY)
+				{
+					std::swap(pRows[0], pRows[1]);
+					std::swap(nRowY[0], nRowY[1]);
+					return;
+				}
+				Pixel *pSrc = sprite->GetRow(nSrcY);
+				for (int32_t i = sx; i < ex; i++)
+				{
+					const sStretchColumn &c = vStretchColumns[i - sx];
+					pRows[nSlot][i - sx] = olc_Lerp(pSrc[c.x0].n, pSrc[c.x1].n, c.nFrac);
+				}
+				nRowY[nSlot] = nSrcY;
+			};
+
+			for (int32_t j = sy; j < ey; j++)
+			{
+				int32_t y0, y1;
+				uint32_t nFracY;
+				olc_StretchSample(j - y, h, oy, oh, y0, y1, nFracY);
+				stretchRow(y0, 0);
+				stretchRow(y1, 1);
+
+				Pixel *pRow = pDrawTarget->GetRow(j);
+				for (int32_t i = sx; i < ex; i++)
+					pRow[i].n = olc_Lerp(pRows[0][i - sx], pRows[1][i - sx], nFracY);
+			}
+		}
+
+#ifdef OLC_DBG_OVERDRAW
+		olc::Sprite::nOverdrawCount += (ex - sx) * (ey - sy);
+#endif
+	}
+
+	// Writes col to the pixels p[i] whose bit i is set, 8 pixels at once
+	static inline void olc_MaskedStore8(Pixel *p, uint8_t bits, Pixel col)
+	{
+#ifdef OLC_SSE2
+		const __m128i vBitsLo = _mm_set_epi32(8, 4, 2, 1);
+		const __m128i vBitsHi = _mm_set_epi32(128, 64, 32, 16);
+		__m128i vSel = _mm_set1_epi32(bits);
+		__m128i vMaskLo = _mm_cmpeq_epi32(_mm_and_si128(vSel, vBitsLo), vBitsLo);
+		__m128i vMaskHi = _mm_cmpeq_epi32(_mm_and_si128(vSel, vBitsHi), vBitsHi);
+		__m128i vCol = _mm_set1_epi32((int)col.n);
+		__m128i *pv = (__m128i*)p;
+		__m128i vLo = _mm_loadu_si128(pv);
+		__m128i vHi = _mm_loadu_si128(pv + 1);
+		vLo = _mm_or_si128(_mm_and_si128(vMaskLo, vCol), _mm_andnot_si128(vMaskLo, vLo));
+		vHi = _mm_or_si128(_mm_and_si128(vMaskHi, vCol), _mm_andnot_si128(vMaskHi, vHi));
+		_mm_storeu_si128(pv, vLo);
+		_mm_storeu_si128(pv + 1, vHi);
+#else
+		for (int i = 0; i < 8; i++)
+			if (bits & (1 << i)) p[i] = col;
+#endif
+	}
+
+	const PixelGameEngine::sTextLayout &PixelGameEngine::olc_LayoutString(const char *sText, size_t nLength, uint32_t scale)
 	{
+		// Recently drawn strings, like a HUD that did not change, are drawn
+		// from their layout without touching the font again
+		nTextUse++;
+		for (auto &t : vTextCache)
+			if (t.nScale == scale && t.sText.size() == nLength && memcmp(t.sText.data(), sText, nLength) == 0)
+			{
+				t.nLastUse = nTextUse;
+				return t;
+			}
+
+		sTextLayout *pLayout;
+		if (vTextCache.size() < 64)
+		{
+			vTextCache.emplace_back();
+			pLayout = &vTextCache.back();
+		}
+		else
+			pLayout = &*std::min_element(vTextCache.begin(), vTextCache.end(),
+				[](const sTextLayout &a, const sTextLayout &b) { return a.nLastUse < b.nLastUse; });
+
+		sTextLayout &t = *pLayout;
+		t.sText.assign(sText, nLength);
+		t.nScale = scale;
+		t.nLastUse = nTextUse;
+
+		int32_t nColumns = 0, nLines = 1, nColumn = 0;
+		for (auto c : t.sText)
+		{
+			if (c == '\n') { nLines++; nColumn = 0; }
+			else nColumns = std::max(nColumns, ++nColumn);
+		}
+		t.nWidth = nColumns * 8 * scale;
+		t.nHeight = nLines * 8 * scale;
+		t.nRowBytes = (t.nWidth + 7) / 8;
+		t.vBits.assign(t.nRowBytes * t.nHeight, 0);
+
 		int32_t sx = 0;
 		int32_t sy = 0;
-		Pixel::Mode m = nPixelMode;
-		if(col.ALPHA != 255)	SetPixelMode(Pixel::ALPHA);
-		else					SetPixelMode(Pixel::MASK);
-		for (auto c : sText)
+		for (auto c : t.sText)
 		{
 			if (c == '\n')
 			{
 				sx = 0; sy += 8 * scale;
+				continue;
 			}
-			else
+
+			// Characters outside the font leave a gap
+			int32_t g = c - 32;
+			if (g >= 0 && g < 96)
+			{
+				for (uint32_t j = 0; j < 8; j++)
+				{
+					uint8_t bits = nFontGlyphs[g][j];
+					if (scale == 1)
+						t.vBits[(sy + j) * t.nRowBytes + sx / 8] = bits;
+					else
+					{
+						for (uint32_t i = 0; i < 8; i++)
+							if (bits & (1 << i))
+								for (uint32_t js = 0; js < scale; js++)
+									for (uint32_t is = 0; is < scale; is++)
+									{
+										int32_t px = sx + i * scale + is;
+										t.vBits[(sy + j * scale + js) * t.nRowBytes + px / 8] |= 1 << (px % 8);
+									}
+					}
+				}
+			}
+			sx += 8 * scale;
+		}
+
+		return t;
+	}
+
+	void PixelGameEngine::DrawString(int32_t x, int32_t y, const std::string &sText, Pixel col, uint32_t scale)
+	{
+		olc_DrawText(x, y, sText.data(), sText.size(), col, scale);
+	}
+
+	void PixelGameEngine::DrawString(int32_t x, int32_t y, const char *sText, Pixel col, uint32_t scale)
+	{
+		olc_DrawText(x, y, sText, strlen(sText), col, scale);
+	}
+
+	void PixelGameEngine::olc_DrawText(int32_t x, int32_t y, const char *sText, size_t nLength, Pixel col, uint32_t scale)
+	{
+		if (!pDrawTarget) return;
+		const sTextLayout &t = olc_LayoutString(sText, nLength, scale);
+
+		// Text is alpha blended, which for an opaque colour at full blend
+		// is plain writes, so those are done straight into the rows
+		bool bOpaque = col.a == 255 && fBlendFactor == 1.0f;
+		Pixel::Mode m = nPixelMode;
+		SetPixelMode(Pixel::ALPHA);
+
+		for (int32_t r = 0; r < t.nHeight; r++)
+		{
+			Pixel *pRow = pDrawTarget->GetRow(y + r);
+			if (pRow == nullptr) continue;
+
+			const uint8_t *pBits = &t.vBits[r * t.nRowBytes];
+			for (int32_t b = 0; b < t.nRowBytes; b++)
 			{
-				int32_t ox = (c - 32) % 16;
-				int32_t oy = (c - 32) / 16;
+				uint8_t bits = pBits[b];
+				if (bits == 0) continue;
 
-				if (scale > 1)
+				int32_t px = x + b * 8;
+				if (bOpaque && px >= 0 && px + 8 <= pDrawTarget->width)
 				{
-					for (uint32_t i = 0; i < 8; i++)
-						for (uint32_t j = 0; j < 8; j++)
-							if (fontSprite->GetPixel(i + ox * 8, j + oy * 8).r > 0)
-								for (uint32_t is = 0; is < scale; is++)
-									for (uint32_t js = 0; js < scale; js++)
-										Draw(x + sx + (i*scale) + is, y + sy + (j*scale) + js, col);
+					olc_MaskedStore8(pRow + px, bits, col);
+#ifdef OLC_DBG_OVERDRAW
+					for (int i = 0; i < 8; i++) olc::Sprite::nOverdrawCount += (bits >> i) & 1;
+#endif
 				}
 				else
 				{
-					for (uint32_t i = 0; i < 8; i++)
-						for (uint32_t j = 0; j < 8; j++)
-							if (fontSprite->GetPixel(i + ox * 8, j + oy * 8).r > 0)								
-								Draw(x + sx + i, y + sy + j, col);
-				}										
-				sx += 8 * scale;
+					for (int32_t i = 0; i < 8; i++)
+						if (bits & (1 << i)) Draw(px + i, y + r, col);
+				}
 			}
 		}
+
 		SetPixelMode(m);
 	}
 
@@ -1651,63 +2342,474 @@ namespace olc
 		if (fBlendFactor > 1.0f) fBlendFactor = 1.0f;
 	}
 
-	// User must override these functions as required. I have not made
-	// them abstract because I do need a default behaviour to occur if
-	// they are not overwritten
-	bool PixelGameEngine::OnUserCreate()
-	{ return false; }
-	bool PixelGameEngine::OnUserUpdate(float fElapsedTime)
-	{ return false; }
-	bool PixelGameEngine::OnUserDestroy()
-	{ return true; }
-	//////////////////////////////////////////////////////////////////
+	void PixelGameEngine::SetRetainedMode(bool bRetained)
+	{
+		bRetainedMode = bRetained;
+		bFullUpload = true;
+	}
 
-	void PixelGameEngine::olc_UpdateViewport()
+	bool PixelGameEngine::IsRetainedMode()
 	{
-		int32_t ww = nScreenWidth * nPixelWidth;
-		int32_t wh = nScreenHeight * nPixelHeight;
-		float wasp = (float)ww / (float)wh;
+		return bRetainedMode;
+	}
 
-		nViewW = nWindowWidth;
-		nViewH = (float)nViewW / wasp;
+	void PixelGameEngine::MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h)
+	{
+		int32_t x2 = std::min(x + w, (int32_t)nScreenWidth);
+		int32_t y2 = std::min(y + h, (int32_t)nScreenHeight);
+		x = std::max(x, 0);
+		y = std::max(y, 0);
+		if (x >= x2 || y >= y2) return;
 
-		if (nViewH > nWindowHeight)
+		sRect r = { x, y, x2 - x, y2 - y };
+
+		// Overlapping areas are merged, uploading a slightly larger area
+		// is cheaper than uploading the shared part twice
+		for (auto it = vDirtyRects.begin(); it != vDirtyRects.end(); )
 		{
-			nViewH = nWindowHeight;
-			nViewW = (float)nViewH * wasp;
+			if (it->x <= r.x + r.w && r.x <= it->x + it->w && it->y <= r.y + r.h && r.y <= it->y + it->h)
+			{
+				int32_t rx2 = std::max(r.x + r.w, it->x + it->w);
+				int32_t ry2 = std::max(r.y + r.h, it->y + it->h);
+				r.x = std::min(r.x, it->x);
+				r.y = std::min(r.y, it->y);
+				r.w = rx2 - r.x;
+				r.h = ry2 - r.y;
+				it = vDirtyRects.erase(it);
+			}
+			else
+				++it;
 		}
 
-		nViewX = (nWindowWidth - nViewW) / 2;
-		nViewY = (nWindowHeight - nViewH) / 2;
+		vDirtyRects.push_back(r);
+
+		// Too many small uploads cost more than one big one
+		if (vDirtyRects.size() > 16)
+		{
+			sRect b = vDirtyRects[0];
+			for (auto &d : vDirtyRects)
+			{
+				int32_t bx2 = std::max(b.x + b.w, d.x + d.w);
+				int32_t by2 = std::max(b.y + b.h, d.y + d.h);
+				b.x = std::min(b.x, d.x);
+				b.y = std::min(b.y, d.y);
+				b.w = bx2 - b.x;
+				b.h = by2 - b.y;
+			}
+			vDirtyRects.clear();
+			vDirtyRects.push_back(b);
+		}
 	}
 
-	void PixelGameEngine::olc_UpdateWindowSize(int32_t x, int32_t y)
+	bool PixelGameEngine::IsFrameStatic()
 	{
-		nWindowWidth = x;
-		nWindowHeight = y;
-		olc_UpdateViewport();
-		
+		return bRetainedMode && !bFullUpload && vDirtyRects.empty();
 	}
 
-	void PixelGameEngine::olc_UpdateMouseWheel(int32_t delta)
+	void PixelGameEngine::SetFramePacing(Pacing mode, float fTargetFps, float fIdleFps)
 	{
-		nMouseWheelDeltaCache += delta;
+		// Frame times are 1 / fps, so rates that are not positive (NaN
+		// included) would give infinite or negative waits
+		if (mode != UNCAPPED && !(fTargetFps > 0.0f))
+		{
+			printf("NOTE: Frame rate %f is not positive, running uncapped\n", fTargetFps);
+			mode = UNCAPPED;
+		}
+		if (mode == ADAPTIVE && !(fIdleFps > 0.0f))
+		{
+			printf("NOTE: Idle frame rate %f is not positive, static frames keep the target rate\n", fIdleFps);
+			fIdleFps = fTargetFps;
+		}
+
+		nPacing = mode;
+		fPacingTargetFps = fTargetFps;
+		fPacingIdleFps = std::min(fIdleFps, fTargetFps);
 	}
 
-	void PixelGameEngine::olc_UpdateMouse(int32_t x, int32_t y)
+	void PixelGameEngine::olc_WaitUntil(std::chrono::steady_clock::time_point tp)
 	{
-		// Mouse coords come in screen space
-		// But leave in pixel space
-
-		//if (bFullScreen)
+		// Sleeping alone overshoots by up to a scheduler tick, so sleep until
+		// shortly before the deadline and spin the remainder. The margin follows
+		// the largest oversleep seen recently
+		auto tNow = std::chrono::steady_clock::now();
+		if (tp - tNow > tSleepSlack)
 		{
-			// Full Screen mode may have a weird viewport we must clamp to
-			x -= nViewX;
-			y -= nViewY;
+			auto tRequested = tp - tNow - tSleepSlack;
+			std::this_thread::sleep_for(tRequested);
+			auto tOver = (std::chrono::steady_clock::now() - tNow) - tRequested;
+			tSleepSlack = std::max(tSleepSlack - tSleepSlack / 16, tOver);
+			tSleepSlack = std::max(tSleepSlack, std::chrono::steady_clock::duration(std::chrono::microseconds(200)));
 		}
 
-		nMousePosXcache = (int32_t)(((float)x / (float)(nWindowWidth - (nViewX * 2)) * (float)nScreenWidth));
-		nMousePosYcache = (int32_t)(((float)y / (float)(nWindowHeight - (nViewY * 2)) * (float)nScreenHeight));
+		while (std::chrono::steady_clock::now() < tp)
+			std::this_thread::yield();
+	}
+
+	void PixelGameEngine::SetPipelined(bool bEnable, uint32_t nBackBuffers)
+	{
+		bPipelined = bEnable;
+		nBackBuffers = std::min(std::max(nBackBuffers, 2u), 3u);
+
+		// One slot per stage with room for a finished frame between them
+		nFrameSlots = bPipelined ? nBackBuffers + 1 : 1;
+
+		for (auto b : vBackBuffers) delete b;
+		vBackBuffers.clear();
+		if (bPipelined)
+			for (uint32_t i = 0; i < nBackBuffers; i++)
+				vBackBuffers.push_back(new Sprite(nScreenWidth, nScreenHeight));
+	}
+
+	uint32_t PixelGameEngine::GetFrameSlots()
+	{
+		return nFrameSlots;
+	}
+
+	uint32_t PixelGameEngine::GetFrameSlot()
+	{
+		return nFrameSlot;
+	}
+
+	void PixelGameEngine::SetJobWorkers(int32_t nWorkers)
+	{
+		nJobWorkers = nWorkers;
+	}
+
+	JobSystem &PixelGameEngine::GetJobs()
+	{
+		return jobs;
+	}
+
+	//==========================================================
+
+	thread_local JobSystem *JobSystem::pCurrentSystem = nullptr;
+	thread_local int32_t JobSystem::nCurrentWorker = -1;
+
+	JobSystem::~JobSystem()
+	{
+		Stop();
+	}
+
+	void JobSystem::Start(int32_t nWorkers)
+	{
+		Stop();
+		vWorkers.clear();
+		nQueued = 0;
+
+		if (nWorkers < 0)
+			nWorkers = std::max((int32_t)std::thread::hardware_concurrency() - 1, 0);
+
+		for (int32_t i = 0; i < nWorkers; i++)
+			vWorkers.push_back(std::unique_ptr<sWorker>(new sWorker()));
+
+		bRunning = true;
+		for (int32_t i = 0; i < nWorkers; i++)
+			vThreads.push_back(std::thread(&JobSystem::olc_WorkerThread, this, i));
+	}
+
+	void JobSystem::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(muxSleep);
+			bRunning = false;
+		}
+		cvSleep.notify_all();
+
+		for (auto &t : vThreads) t.join();
+		vThreads.clear();
+
+		// The deques stay, other threads may still be looking into them,
+		// and whatever they hold is run here so that no Wait is left hanging
+		while (olc_RunOne());
+	}
+
+	uint32_t JobSystem::GetWorkerCount()
+	{
+		return (uint32_t)vWorkers.size();
+	}
+
+	JobSystem::Job JobSystem::Submit(std::function<void()> func, const std::vector<Job> &vDependencies)
+	{
+		Job job = std::make_shared<sJob>();
+		job->func = std::move(func);
+
+		for (auto &dep : vDependencies)
+		{
+			std::lock_guard<std::mutex> lock(dep->mux);
+			if (!dep->bDone)
+			{
+				job->nPending++;
+				dep->vDependents.push_back(job);
+			}
+		}
+
+		// Dependencies that finished meanwhile already counted down
+		if (--job->nPending == 0) olc_Ready(job);
+		return job;
+	}
+
+	void JobSystem::Wait(const Job &job)
+	{
+		bool bWorker = pCurrentSystem == this && nCurrentWorker >= 0;
+
+		while (!job->bDone)
+		{
+			// Workers help with anything, other threads only with this job,
+			// once it is queued and nobody else took it. Either way the wait
+			// ends, a queued job is run by someone and a running one finishes
+			bool bRan = bWorker ? olc_RunOne() : (job->bQueued && olc_Run(job));
+			if (!bRan)
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32_t nCount, uint32_t nGrain, const std::function<void(uint32_t, uint32_t)> &func)
+	{
+		nGrain = std::max(nGrain, 1u);
+
+		if (vWorkers.empty() || !bRunning || nCount <= nGrain)
+		{
+			for (uint32_t nBegin = 0; nBegin < nCount; nBegin += nGrain)
+				func(nBegin, std::min(nBegin + nGrain, nCount));
+			return;
+		}
+
+		std::vector<Job> vJobs;
+		for (uint32_t nBegin = 0; nBegin < nCount; nBegin += nGrain)
+		{
+			uint32_t nEnd = std::min(nBegin + nGrain, nCount);
+			vJobs.push_back(Submit([&func, nBegin, nEnd]() { func(nBegin, nEnd); }));
+		}
+
+		// Last first, the workers take the oldest ones
+		for (auto it = vJobs.rbegin(); it != vJobs.rend(); ++it) Wait(*it);
+	}
+
+	void JobSystem::olc_Ready(const Job &job)
+	{
+		if (vWorkers.empty() || !bRunning)
+		{
+			olc_Run(job);
+			return;
+		}
+
+		// Workers keep what they make ready, other threads hand it out in turn
+		int32_t nWorker = pCurrentSystem == this ? nCurrentWorker : (int32_t)(nNextWorker++ % vWorkers.size());
+		{
+			// Counted before it can be taken so the count never drops below zero
+			std::lock_guard<std::mutex> lock(muxSleep);
+			nQueued++;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(vWorkers[nWorker]->mux);
+			vWorkers[nWorker]->dqJobs.push_back(job);
+		}
+		job->bQueued = true;
+		cvSleep.notify_one();
+	}
+
+	bool JobSystem::olc_Run(const Job &job)
+	{
+		if (job->bClaimed.exchange(true))
+			return false;
+
+		job->func();
+
+		std::vector<Job> vDependents;
+		{
+			std::lock_guard<std::mutex> lock(job->mux);
+			job->bDone = true;
+			vDependents.swap(job->vDependents);
+		}
+
+		for (auto &dep : vDependents)
+			if (--dep->nPending == 0) olc_Ready(dep);
+		return true;
+	}
+
+	bool JobSystem::olc_RunOne()
+	{
+		int32_t nOwn = pCurrentSystem == this ? nCurrentWorker : -1;
+
+		// Taken jobs may have been claimed by a thread waiting for them,
+		// those are only dropped from the queue
+		while (!vWorkers.empty())
+		{
+			Job job;
+
+			// Newest job of our own deque first, it is the most likely to be in cache
+			if (nOwn >= 0)
+			{
+				std::lock_guard<std::mutex> lock(vWorkers[nOwn]->mux);
+				if (!vWorkers[nOwn]->dqJobs.empty())
+				{
+					job = vWorkers[nOwn]->dqJobs.back();
+					vWorkers[nOwn]->dqJobs.pop_back();
+				}
+			}
+
+			// Otherwise the oldest job of someone else
+			for (size_t i = 1; !job && i <= vWorkers.size(); i++)
+			{
+				size_t nVictim = (size_t)(nOwn + i) % vWorkers.size();
+				std::lock_guard<std::mutex> lock(vWorkers[nVictim]->mux);
+				if (!vWorkers[nVictim]->dqJobs.empty())
+				{
+					job = vWorkers[nVictim]->dqJobs.front();
+					vWorkers[nVictim]->dqJobs.pop_front();
+				}
+			}
+
+			if (!job) return false;
+
+			nQueued--;
+			if (olc_Run(job)) return true;
+		}
+
+		return false;
+	}
+
+	void JobSystem::olc_WorkerThread(int32_t nWorker)
+	{
+		pCurrentSystem = this;
+		nCurrentWorker = nWorker;
+
+		while (bRunning)
+		{
+			if (olc_RunOne()) continue;
+
+			// Sleep until something is queued, the timeout covers a job
+			// queued between the check and the wait
+			std::unique_lock<std::mutex> lock(muxSleep);
+			cvSleep.wait_for(lock, std::chrono::milliseconds(1), [this]() { return nQueued > 0 || !bRunning; });
+		}
+	}
+
+	//==========================================================
+
+	void PixelGameEngine::olc_PipelineWait(std::function<bool()> ready)
+	{
+		// Handoffs are usually quick, so spin a little first, but an idle
+		// pipeline must not keep a core busy
+		for (int i = 0; !ready(); i++)
+		{
+			if (!bPipelineActive) return;
+			if (i < 64)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(250));
+		}
+	}
+
+	void PixelGameEngine::RenderThread()
+	{
+		while (bPipelineActive)
+		{
+			uint32_t nSlot = 0, nBuffer = 0;
+			olc_PipelineWait([&] { return qRender.pop(nSlot); });
+			if (!bPipelineActive) break;
+			olc_PipelineWait([&] { return qFreeBuffers.pop(nBuffer); });
+			if (!bPipelineActive) break;
+
+			// The back buffer stands in for the screen while this frame is drawn
+			pDefaultDrawTarget = vBackBuffers[nBuffer];
+			SetDrawTarget(nullptr);
+			if (!OnUserRender(nSlot))
+				bAtomActive = false;
+
+			qPresent.push(nSlot | (nBuffer << 16));
+		}
+	}
+
+	void PixelGameEngine::PresentThread()
+	{
+		// The presenting backend, OpenGL context included, belongs to
+		// this thread when pipelined. Without one frames are still retired
+		// so that the game thread can shut down
+		if (!olc_BackendCreate())
+			bAtomActive = false;
+
+		for (uint32_t i = 0; i < vBackBuffers.size(); i++)
+			qFreeBuffers.push(i);
+
+		while (bPipelineActive)
+		{
+			uint32_t nToken = 0;
+			olc_PipelineWait([&] { return qPresent.pop(nToken); });
+			if (!bPipelineActive) break;
+
+			uint32_t nSlot = nToken & 0xFFFF;
+			uint32_t nBuffer = nToken >> 16;
+			olc_BackendPresent(vBackBuffers[nBuffer], vFrames[nSlot]);
+
+			// Both the back buffer and the frame slot can be reused now
+			qFreeBuffers.push(nBuffer);
+			nFramesRetired++;
+		}
+
+		olc_BackendDestroy();
+	}
+
+	// User must override these functions as required. I have not made
+	// them abstract because I do need a default behaviour to occur if
+	// they are not overwritten
+	bool PixelGameEngine::OnUserCreate()
+	{ return false; }
+	bool PixelGameEngine::OnUserUpdate(float fElapsedTime)
+	{ return false; }
+	bool PixelGameEngine::OnUserRender(uint32_t nFrameSlot)
+	{ return true; }
+	bool PixelGameEngine::OnUserDestroy()
+	{ return true; }
+	//////////////////////////////////////////////////////////////////
+
+	void PixelGameEngine::olc_UpdateViewport()
+	{
+		int32_t ww = nScreenWidth * nPixelWidth;
+		int32_t wh = nScreenHeight * nPixelHeight;
+		float wasp = (float)ww / (float)wh;
+
+		nViewW = nWindowWidth;
+		nViewH = (float)nViewW / wasp;
+
+		if (nViewH > nWindowHeight)
+		{
+			nViewH = nWindowHeight;
+			nViewW = (float)nViewH * wasp;
+		}
+
+		nViewX = (nWindowWidth - nViewW) / 2;
+		nViewY = (nWindowHeight - nViewH) / 2;
+	}
+
+	void PixelGameEngine::olc_UpdateWindowSize(int32_t x, int32_t y)
+	{
+		nWindowWidth = x;
+		nWindowHeight = y;
+		olc_UpdateViewport();
+		bFullUpload = true;
+	}
+
+	void PixelGameEngine::olc_UpdateMouseWheel(int32_t delta)
+	{
+		nMouseWheelDeltaCache += delta;
+	}
+
+	void PixelGameEngine::olc_UpdateMouse(int32_t x, int32_t y)
+	{
+		// Mouse coords come in screen space
+		// But leave in pixel space
+
+		//if (bFullScreen)
+		{
+			// Full Screen mode may have a weird viewport we must clamp to
+			x -= nViewX;
+			y -= nViewY;
+		}
+
+		nMousePosXcache = (int32_t)(((float)x / (float)(nWindowWidth - (nViewX * 2)) * (float)nScreenWidth));
+		nMousePosYcache = (int32_t)(((float)y / (float)(nWindowHeight - (nViewY * 2)) * (float)nScreenHeight));
 
 		if (nMousePosXcache >= (int32_t)nScreenWidth)
 			nMousePosXcache = nScreenWidth - 1;
@@ -1722,26 +2824,27 @@ namespace olc
 
 	void PixelGameEngine::EngineThread()
 	{
-		// Start OpenGL, the context is owned by the game thread
-		olc_OpenGLCreate();
-
-		// Create Screen Texture - disable filtering
-		glEnable(GL_TEXTURE_2D);
-		glGenTextures(1, &glBuffer);
-		glBindTexture(GL_TEXTURE_2D, glBuffer);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, nScreenWidth, nScreenHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pDefaultDrawTarget->GetData());
+		// Start presenting, the backend is owned by the game thread, unless
+		// presenting has a thread of its own
+		vFrames.resize(nFrameSlots);
+		std::thread tRender, tPresent;
+		if (bPipelined)
+		{
+			bPipelineActive = true;
+			tRender = std::thread(&PixelGameEngine::RenderThread, this);
+			tPresent = std::thread(&PixelGameEngine::PresentThread, this);
+		}
+		else if (!olc_BackendCreate())
+			bAtomActive = false;
 
 
 		// Create user resources as part of this thread
 		if (!OnUserCreate())
 			bAtomActive = false;
 
-		auto tp1 = std::chrono::system_clock::now();
-		auto tp2 = std::chrono::system_clock::now();
+		auto tp1 = std::chrono::steady_clock::now();
+		auto tp2 = std::chrono::steady_clock::now();
+		auto tpNextFrame = tp1;
 
 		while (bAtomActive)
 		{
@@ -1749,7 +2852,7 @@ namespace olc
 			while (bAtomActive)
 			{
 				// Handle Timing
-				tp2 = std::chrono::system_clock::now();
+				tp2 = std::chrono::steady_clock::now();
 				std::chrono::duration<float> elapsedTime = tp2 - tp1;
 				tp1 = tp2;
 
@@ -1761,7 +2864,7 @@ namespace olc
 				// same thread that OpenGL was created so we dont
 				// need to worry too much about multithreading with X11
 				XEvent xev;
-				while (XPending(olc_Display))
+				while (olc_Display && XPending(olc_Display))
 				{
 					XNextEvent(olc_Display, &xev);
 					if (xev.type == Expose)
@@ -1771,13 +2874,14 @@ namespace olc
 						nWindowWidth = gwa.width;
 						nWindowHeight = gwa.height;
 						olc_UpdateViewport();
-						glClear(GL_COLOR_BUFFER_BIT); // Thanks Benedani!
+						bFullUpload = true; // Full presents clear the window first, thanks Benedani!
 					}
 					else if (xev.type == ConfigureNotify)
 					{
 						XConfigureEvent xce = xev.xconfigure;
 						nWindowWidth = xce.width;
 						nWindowHeight = xce.height;
+						bFullUpload = true;
 					}
 					else if (xev.type == KeyPress)
 					{
@@ -1894,31 +2998,57 @@ namespace olc
 				olc::Sprite::nOverdrawCount = 0;
 #endif
 
+				// Wait until the frame slot to be filled has left the pipeline
+				if (bPipelined)
+					olc_PipelineWait([&] { return nFramesSubmitted - nFramesRetired < nFrameSlots; });
+				nFrameSlot = nFramesSubmitted % nFrameSlots;
+
 				// Handle Frame Update
 				if (!OnUserUpdate(fElapsedTime))
 					bAtomActive = false;
 
-				// Display Graphics
-				glViewport(nViewX, nViewY, nViewW, nViewH);
-
-				// TODO: This is a bit slow (especially in debug, but 100x faster in release mode???)
-				// Copy pixel array into texture
-				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, nScreenWidth, nScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, pDefaultDrawTarget->GetData());
-				
-				// Display texture on screen
-				glBegin(GL_QUADS);
-					glTexCoord2f(0.0, 1.0); glVertex3f(-1.0f + (fSubPixelOffsetX), -1.0f + (fSubPixelOffsetY), 0.0f);
-					glTexCoord2f(0.0, 0.0); glVertex3f(-1.0f + (fSubPixelOffsetX),  1.0f + (fSubPixelOffsetY), 0.0f);
-					glTexCoord2f(1.0, 0.0); glVertex3f( 1.0f + (fSubPixelOffsetX),  1.0f + (fSubPixelOffsetY), 0.0f);
-					glTexCoord2f(1.0, 1.0); glVertex3f( 1.0f + (fSubPixelOffsetX), -1.0f + (fSubPixelOffsetY), 0.0f);
-				glEnd();
-
-				// Present Graphics to screen
-#ifdef _WIN32
-				SwapBuffers(glDeviceContext);
-#else
-				glXSwapBuffers(olc_Display, olc_Window);
-#endif
+				// Static retained frames leave the screen as it is, they are
+				// neither rendered nor presented, and neither is a frame whose
+				// update shut the engine down, as it may not have left any data
+				bool bStatic = !bAtomActive || IsFrameStatic();
+				if (!bStatic)
+				{
+					sFrame &frame = vFrames[nFrameSlot];
+					frame.vDirtyRects.swap(vDirtyRects);
+					frame.bFull = !bRetainedMode || bFullUpload;
+					frame.rView = { nViewX, nViewY, nViewW, nViewH };
+					frame.nWindowWidth = nWindowWidth;
+					frame.nWindowHeight = nWindowHeight;
+
+					if (bPipelined)
+					{
+						qRender.push(nFrameSlot);
+						nFramesSubmitted++;
+					}
+					else
+					{
+						if (!OnUserRender(nFrameSlot))
+							bAtomActive = false;
+						olc_BackendPresent(pDefaultDrawTarget, frame);
+					}
+				}
+
+				vDirtyRects.clear();
+				bFullUpload = false;
+
+				// Frame Pacing
+				if (nPacing != UNCAPPED)
+				{
+					float fFps = (nPacing == ADAPTIVE && bStatic) ? fPacingIdleFps : fPacingTargetFps;
+					tpNextFrame += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.0f / fFps));
+
+					// Dont try to catch up after a long frame, that just causes a burst
+					auto tNow = std::chrono::steady_clock::now();
+					if (tpNextFrame < tNow)
+						tpNextFrame = tNow;
+					else
+						olc_WaitUntil(tpNextFrame);
+				}
 
 				// Update Title Bar
 				fFrameTimer += fElapsedTime;
@@ -1930,17 +3060,22 @@ namespace olc
 					std::string sTitle = sAppName + " (FPS: " + std::to_string(nFrameCount)+")";
 #ifdef _WIN32
 #ifdef UNICODE
-					SetWindowText(olc_hWnd, ConvertS2W(sTitle).c_str());
+					if (olc_hWnd) SetWindowText(olc_hWnd, ConvertS2W(sTitle).c_str());
 #else
-					SetWindowText(olc_hWnd, sTitle.c_str());
+					if (olc_hWnd) SetWindowText(olc_hWnd, sTitle.c_str());
 #endif
 #else					
-					XStoreName(olc_Display, olc_Window, sTitle.c_str());
+					if (olc_Display) XStoreName(olc_Display, olc_Window, sTitle.c_str());
 #endif
 					nFrameCount = 0;
 				}
 			}
 
+			// Frames already submitted still reach the screen, and the render
+			// thread must be done with user resources before they are freed
+			if (bPipelined)
+				olc_PipelineWait([&] { return nFramesRetired == nFramesSubmitted; });
+
 			// Allow the user to free resources if they have overrided the destroy function
 			if (OnUserDestroy())
 			{
@@ -1953,16 +3088,479 @@ namespace olc
 			}
 		}
 
+		if (bPipelined)
+		{
+			// Drained before OnUserDestroy, nothing was submitted since
+			bPipelineActive = false;
+			tRender.join();
+			tPresent.join();
+		}
+		else
+			olc_BackendDestroy();
+
+#ifdef _WIN32
+		if (olc_hWnd) PostMessage(olc_hWnd, WM_DESTROY, 0, 0);
+#else
+		if (olc_Display)
+		{
+			XDestroyWindow(olc_Display, olc_Window);
+			XCloseDisplay(olc_Display);
+		}
+#endif
+
+	}
+
+	bool PixelGameEngine::olc_LoadGLFunctions()
+	{
+		olc_glGenBuffers = (glGenBuffers_t*)olc_GetGLProc("glGenBuffers");
+		olc_glDeleteBuffers = (glDeleteBuffers_t*)olc_GetGLProc("glDeleteBuffers");
+		olc_glBindBuffer = (glBindBuffer_t*)olc_GetGLProc("glBindBuffer");
+		olc_glBufferData = (glBufferData_t*)olc_GetGLProc("glBufferData");
+		olc_glMapBufferRange = (glMapBufferRange_t*)olc_GetGLProc("glMapBufferRange");
+		olc_glUnmapBuffer = (glUnmapBuffer_t*)olc_GetGLProc("glUnmapBuffer");
+		olc_glCreateShader = (glCreateShader_t*)olc_GetGLProc("glCreateShader");
+		olc_glShaderSource = (glShaderSource_t*)olc_GetGLProc("glShaderSource");
+		olc_glCompileShader = (glCompileShader_t*)olc_GetGLProc("glCompileShader");
+		olc_glGetShaderiv = (glGetShaderiv_t*)olc_GetGLProc("glGetShaderiv");
+		olc_glDeleteShader = (glDeleteShader_t*)olc_GetGLProc("glDeleteShader");
+		olc_glCreateProgram = (glCreateProgram_t*)olc_GetGLProc("glCreateProgram");
+		olc_glAttachShader = (glAttachShader_t*)olc_GetGLProc("glAttachShader");
+		olc_glLinkProgram = (glLinkProgram_t*)olc_GetGLProc("glLinkProgram");
+		olc_glGetProgramiv = (glGetProgramiv_t*)olc_GetGLProc("glGetProgramiv");
+		olc_glUseProgram = (glUseProgram_t*)olc_GetGLProc("glUseProgram");
+		olc_glDeleteProgram = (glDeleteProgram_t*)olc_GetGLProc("glDeleteProgram");
+		olc_glGetUniformLocation = (glGetUniformLocation_t*)olc_GetGLProc("glGetUniformLocation");
+		olc_glUniform2f = (glUniform2f_t*)olc_GetGLProc("glUniform2f");
+		olc_glGenVertexArrays = (glGenVertexArrays_t*)olc_GetGLProc("glGenVertexArrays");
+		olc_glBindVertexArray = (glBindVertexArray_t*)olc_GetGLProc("glBindVertexArray");
+		olc_glDeleteVertexArrays = (glDeleteVertexArrays_t*)olc_GetGLProc("glDeleteVertexArrays");
+
+		// Only the buffer functions are needed outside of a core profile
+		return olc_glGenBuffers && olc_glDeleteBuffers && olc_glBindBuffer && olc_glBufferData && olc_glMapBufferRange && olc_glUnmapBuffer;
+	}
+
+	bool PixelGameEngine::olc_PresentCreate()
+	{
+		bGLStreaming = olc_LoadGLFunctions();
+
+		// Create Screen Texture - disable filtering
+		if (!bGLCoreProfile) glEnable(GL_TEXTURE_2D);
+		glGenTextures(1, &glBuffer);
+		glBindTexture(GL_TEXTURE_2D, glBuffer);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		if (!bGLCoreProfile) glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
+
+		// Contents arrive with the first frame, which is always a full one
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, nScreenWidth, nScreenHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+		// Two pixel buffers, the driver uploads from one while the next
+		// frame is written into the other
+		if (bGLStreaming)
+		{
+			olc_glGenBuffers(2, glPixelBuffers);
+			for (int i = 0; i < 2; i++)
+			{
+				olc_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, glPixelBuffers[i]);
+				olc_glBufferData(GL_PIXEL_UNPACK_BUFFER, nScreenWidth * nScreenHeight * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+			}
+			olc_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		if (!bGLCoreProfile)
+			return true;
+
+		// Core profile has no immediate mode, the screen is one triangle covering
+		// the viewport with its vertices generated from gl_VertexID. Texels with
+		// alpha < 255 are blended to white like the GL_DECAL path does
+		const GLchar *sVertexShader =
+			"#version 330 core\n"
+			"uniform vec2 offset;\n"
+			"out vec2 uv;\n"
+			"void main()\n"
+			"{\n"
+			"	vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+			"	uv = vec2(p.x, 1.0 - p.y);\n"
+			"	gl_Position = vec4(p * 2.0 - 1.0 + offset, 0.0, 1.0);\n"
+			"}\n";
+		const GLchar *sFragmentShader =
+			"#version 330 core\n"
+			"uniform sampler2D screen;\n"
+			"in vec2 uv;\n"
+			"out vec4 colour;\n"
+			"void main()\n"
+			"{\n"
+			"	vec4 t = texture(screen, uv);\n"
+			"	colour = vec4(mix(vec3(1.0), t.rgb, t.a), 1.0);\n"
+			"}\n";
+
+		auto CompileShader = [&](GLenum type, const GLchar *source)
+		{
+			GLuint shader = olc_glCreateShader(type);
+			olc_glShaderSource(shader, 1, &source, nullptr);
+			olc_glCompileShader(shader);
+			GLint status = 0;
+			olc_glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+			if (!status) printf("NOTE: Screen shader failed to compile\n");
+			return shader;
+		};
+
+		GLuint vs = CompileShader(GL_VERTEX_SHADER, sVertexShader);
+		GLuint fs = CompileShader(GL_FRAGMENT_SHADER, sFragmentShader);
+		glScreenProgram = olc_glCreateProgram();
+		olc_glAttachShader(glScreenProgram, vs);
+		olc_glAttachShader(glScreenProgram, fs);
+		olc_glLinkProgram(glScreenProgram);
+		olc_glDeleteShader(vs);
+		olc_glDeleteShader(fs);
+
+		GLint status = 0;
+		olc_glGetProgramiv(glScreenProgram, GL_LINK_STATUS, &status);
+		if (!status)
+		{
+			printf("NOTE: Screen shader failed to link\n");
+			return false;
+		}
+
+		olc_glUseProgram(glScreenProgram);
+		glOffsetUniform = olc_glGetUniformLocation(glScreenProgram, "offset");
+
+		// A core profile needs a vertex array bound to draw, even with no attributes
+		olc_glGenVertexArrays(1, &glScreenVertexArray);
+		olc_glBindVertexArray(glScreenVertexArray);
+		return true;
+	}
+
+	void PixelGameEngine::olc_PresentFrame(Sprite *pFrame, const sFrame &frame)
+	{
+		// Display Graphics, full frames also clear the borders around the viewport
+		if (frame.bFull) glClear(GL_COLOR_BUFFER_BIT);
+		glViewport(frame.rView.x, frame.rView.y, frame.rView.w, frame.rView.h);
+
+		sRect rScreen = { 0, 0, (int32_t)nScreenWidth, (int32_t)nScreenHeight };
+		const sRect *pRects = frame.bFull ? &rScreen : frame.vDirtyRects.data();
+		size_t nRects = frame.bFull ? 1 : frame.vDirtyRects.size();
+		Pixel *pData = pFrame->GetData();
+
+		// Copy pixel array into texture, area by area, the texture still holds
+		// everything outside of them
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, nScreenWidth);
+
+		uint8_t *pMapped = nullptr;
+		if (bGLStreaming)
+		{
+			olc_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, glPixelBuffers[nPixelBuffer]);
+			// Invalidating lets the driver hand out fresh memory instead of
+			// waiting for a transfer still reading the old contents
+			pMapped = (uint8_t*)olc_glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, nScreenWidth * nScreenHeight * sizeof(uint32_t), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			if (pMapped == nullptr)
+				olc_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		if (pMapped)
+		{
+			// Same layout as the sprite, offsets into the buffer replace pointers
+			for (size_t i = 0; i < nRects; i++)
+			{
+				const sRect &r = pRects[i];
+				for (int32_t y = r.y; y < r.y + r.h; y++)
+					memcpy(pMapped + (y * nScreenWidth + r.x) * sizeof(uint32_t), pData + y * nScreenWidth + r.x, r.w * sizeof(uint32_t));
+			}
+			olc_glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+			for (size_t i = 0; i < nRects; i++)
+			{
+				const sRect &r = pRects[i];
+				glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.w, r.h, GL_RGBA, GL_UNSIGNED_BYTE, (void*)((size_t)(r.y * nScreenWidth + r.x) * sizeof(uint32_t)));
+			}
+
+			olc_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			nPixelBuffer = 1 - nPixelBuffer;
+		}
+		else
+		{
+			for (size_t i = 0; i < nRects; i++)
+			{
+				const sRect &r = pRects[i];
+				glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.w, r.h, GL_RGBA, GL_UNSIGNED_BYTE, pData + r.y * nScreenWidth + r.x);
+			}
+		}
+
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+		// Display texture on screen
+		if (bGLCoreProfile)
+		{
+			olc_glUniform2f(glOffsetUniform, fSubPixelOffsetX, fSubPixelOffsetY);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}
+		else
+		{
+			glBegin(GL_QUADS);
+				glTexCoord2f(0.0, 1.0); glVertex3f(-1.0f + (fSubPixelOffsetX), -1.0f + (fSubPixelOffsetY), 0.0f);
+				glTexCoord2f(0.0, 0.0); glVertex3f(-1.0f + (fSubPixelOffsetX),  1.0f + (fSubPixelOffsetY), 0.0f);
+				glTexCoord2f(1.0, 0.0); glVertex3f( 1.0f + (fSubPixelOffsetX),  1.0f + (fSubPixelOffsetY), 0.0f);
+				glTexCoord2f(1.0, 1.0); glVertex3f( 1.0f + (fSubPixelOffsetX), -1.0f + (fSubPixelOffsetY), 0.0f);
+			glEnd();
+		}
+
+		// Present Graphics to screen
+#ifdef _WIN32
+		SwapBuffers(glDeviceContext);
+#else
+		glXSwapBuffers(olc_Display, olc_Window);
+#endif
+	}
+
+	bool PixelGameEngine::olc_BackendCreate()
+	{
+		if (nBackend != OPENGL)
+			bBackendReady = olc_SoftwarePresentCreate();
+		else if (!olc_OpenGLCreate())
+			bBackendReady = false;
+		else if (olc_PresentCreate())
+			bBackendReady = true;
+		else if (bGLCoreProfile)
+		{
+			// Only the core profile needs the screen shader, the fixed
+			// function path of a legacy context does without
+			printf("NOTE: Falling back to a legacy OpenGL context\n");
+			olc_OpenGLDestroy();
+			bGLLegacyOnly = true;
+			bBackendReady = olc_OpenGLCreate() && olc_PresentCreate();
+		}
+		else
+			bBackendReady = false;
+
+		if (!bBackendReady)
+			printf("ERROR: Could not create the presenting backend, nothing can be shown\n");
+		return bBackendReady;
+	}
+
+	void PixelGameEngine::olc_BackendPresent(Sprite *pFrame, const sFrame &frame)
+	{
+		if (!bBackendReady)
+			return;
+
+		if (nBackend == OPENGL)
+			olc_PresentFrame(pFrame, frame);
+		else
+			olc_SoftwarePresentFrame(pFrame, frame);
+	}
+
+	void PixelGameEngine::olc_BackendDestroy()
+	{
+		if (!bBackendReady)
+			return;
+		bBackendReady = false;
+
+		if (nBackend == OPENGL)
+			olc_OpenGLDestroy();
+		else
+			olc_SoftwarePresentDestroy();
+	}
+
+	bool PixelGameEngine::olc_SoftwarePresentCreate()
+	{
+		if (nBackend == HEADLESS)
+		{
+			if (!sHeadlessFile.empty())
+			{
+				pHeadlessFile = fopen(sHeadlessFile.c_str(), "wb");
+				if (!pHeadlessFile) printf("NOTE: Could not open %s, frames are dropped\n", sHeadlessFile.c_str());
+			}
+			return true;
+		}
+
+#ifndef _WIN32
+		// The image covers the whole window at its initial size, so the
+		// server only ever copies it, scaling happens while converting
+		uint32_t w = nScreenWidth * nPixelWidth;
+		uint32_t h = nScreenHeight * nPixelHeight;
+		olc_GC = XCreateGC(olc_Display, olc_Window, 0, nullptr);
+
+		// Shared memory saves sending every frame through the socket, it is
+		// refused by remote displays, which then get plain XPutImage
+		bXShm = XShmQueryExtension(olc_Display);
+		if (bXShm)
+		{
+			olc_Image = XShmCreateImage(olc_Display, olc_VisualInfo->visual, olc_VisualInfo->depth, ZPixmap, nullptr, &olc_ShmInfo, w, h);
+			olc_ShmInfo.shmid = olc_Image ? shmget(IPC_PRIVATE, olc_Image->bytes_per_line * h, IPC_CREAT | 0600) : -1;
+			olc_ShmInfo.shmaddr = olc_ShmInfo.shmid < 0 ? (char*)-1 : (char*)shmat(olc_ShmInfo.shmid, nullptr, 0);
+			olc_ShmInfo.readOnly = False;
+			bXShm = olc_ShmInfo.shmaddr != (char*)-1;
+
+			if (bXShm)
+			{
+				olc_Image->data = olc_ShmInfo.shmaddr;
+
+				static bool bShmError;
+				bShmError = false;
+				auto oldHandler = XSetErrorHandler([](Display*, XErrorEvent*) { bShmError = true; return 0; });
+				XShmAttach(olc_Display, &olc_ShmInfo);
+				XSync(olc_Display, False);
+				XSetErrorHandler(oldHandler);
+				bXShm = !bShmError;
+				if (!bXShm) shmdt(olc_ShmInfo.shmaddr);
+			}
+
+			// Removed as soon as both sides have detached, even after a crash
+			if (olc_ShmInfo.shmid >= 0)
+				shmctl(olc_ShmInfo.shmid, IPC_RMID, nullptr);
+
+			if (!bXShm && olc_Image)
+			{
+				olc_Image->data = nullptr;
+				XDestroyImage(olc_Image);
+				olc_Image = nullptr;
+			}
+		}
+
+		if (!bXShm)
+		{
+			printf("NOTE: MIT-SHM is not available, frames are sent with XPutImage\n");
+			olc_Image = XCreateImage(olc_Display, olc_VisualInfo->visual, olc_VisualInfo->depth, ZPixmap, 0, nullptr, w, h, 32, 0);
+			olc_Image->data = (char*)malloc(olc_Image->bytes_per_line * h);
+		}
+
+		// 32 bit images with 8 bit channels are written directly, anything
+		// else goes through XPutPixel
+		auto Shift = [](unsigned long mask)
+		{
+			int shift = 0;
+			while (shift < 32 && !(mask & (1ul << shift))) shift++;
+			return (mask >> shift) == 0xFF ? shift : -1;
+		};
+		nShiftR = Shift(olc_Image->red_mask);
+		nShiftG = Shift(olc_Image->green_mask);
+		nShiftB = Shift(olc_Image->blue_mask);
+		bDirectPixels = olc_Image->bits_per_pixel == 32 && nShiftR >= 0 && nShiftG >= 0 && nShiftB >= 0;
+#endif
+		return true;
+	}
+
+	void PixelGameEngine::olc_SoftwarePresentFrame(Sprite *pFrame, const sFrame &frame)
+	{
+		// Raw files always get whole frames, whatever changed
+		if (nBackend == HEADLESS)
+		{
+			if (pHeadlessFile) fwrite(pFrame->GetData(), sizeof(Pixel), nScreenWidth * nScreenHeight, pHeadlessFile);
+			return;
+		}
+
+#ifndef _WIN32
+		sRect rScreen = { 0, 0, (int32_t)nScreenWidth, (int32_t)nScreenHeight };
+		const sRect *pRects = frame.bFull ? &rScreen : frame.vDirtyRects.data();
+		size_t nRects = frame.bFull ? 1 : frame.vDirtyRects.size();
+		Pixel *pData = pFrame->GetData();
+		uint32_t nBytesPerPixel = olc_Image->bits_per_pixel / 8;
+
+		// Centred in the window, the window background fills the rest
+		int32_t nOffsetX = std::max(0, (frame.nWindowWidth - olc_Image->width) / 2);
+		int32_t nOffsetY = std::max(0, (frame.nWindowHeight - olc_Image->height) / 2);
+
+		for (size_t i = 0; i < nRects; i++)
+		{
+			const sRect &r = pRects[i];
+			int32_t ix = r.x * nPixelWidth;
+			for (int32_t y = r.y; y < r.y + r.h; y++)
+			{
+				const Pixel *pSrc = pData + y * nScreenWidth + r.x;
+				int32_t iy = y * nPixelHeight;
+				uint32_t *pDst = (uint32_t*)(olc_Image->data + iy * olc_Image->bytes_per_line) + ix;
+				for (int32_t x = 0; x < r.w; x++)
+				{
+					// Texels with alpha < 255 are blended to white like the OpenGL path does
+					Pixel p = pSrc[x];
+					uint32_t cr = p.r, cg = p.g, cb = p.b;
+					if (p.a != 255)
+					{
+						cr = 255 - (255 - cr) * p.a / 255;
+						cg = 255 - (255 - cg) * p.a / 255;
+						cb = 255 - (255 - cb) * p.a / 255;
+					}
+
+					if (bDirectPixels)
+					{
+						uint32_t n = cr << nShiftR | cg << nShiftG | cb << nShiftB;
+						for (uint32_t px = 0; px < nPixelWidth; px++) *pDst++ = n;
+					}
+					else
+					{
+						unsigned long n = ((cr * olc_Image->red_mask / 255) & olc_Image->red_mask)
+							| ((cg * olc_Image->green_mask / 255) & olc_Image->green_mask)
+							| ((cb * olc_Image->blue_mask / 255) & olc_Image->blue_mask);
+						for (uint32_t px = 0; px < nPixelWidth; px++) XPutPixel(olc_Image, ix + x * nPixelWidth + px, iy, n);
+					}
+				}
+
+				// Taller pixels repeat the row just converted
+				char *pRow = olc_Image->data + iy * olc_Image->bytes_per_line + ix * nBytesPerPixel;
+				for (uint32_t py = 1; py < nPixelHeight; py++)
+					memcpy(pRow + py * olc_Image->bytes_per_line, pRow, r.w * nPixelWidth * nBytesPerPixel);
+			}
+
+			int32_t iy = r.y * nPixelHeight;
+			if (bXShm)
+				XShmPutImage(olc_Display, olc_Window, olc_GC, olc_Image, ix, iy, nOffsetX + ix, nOffsetY + iy, r.w * nPixelWidth, r.h * nPixelHeight, False);
+			else
+				XPutImage(olc_Display, olc_Window, olc_GC, olc_Image, ix, iy, nOffsetX + ix, nOffsetY + iy, r.w * nPixelWidth, r.h * nPixelHeight);
+		}
+
+		// The server reads the shared image asynchronously, it must be done
+		// before the next frame is converted into it
+		XSync(olc_Display, False);
+#endif
+	}
+
+	void PixelGameEngine::olc_SoftwarePresentDestroy()
+	{
+		if (pHeadlessFile)
+		{
+			fclose(pHeadlessFile);
+			pHeadlessFile = nullptr;
+		}
+
+#ifndef _WIN32
+		if (olc_Image)
+		{
+			if (bXShm)
+			{
+				XShmDetach(olc_Display, &olc_ShmInfo);
+				XSync(olc_Display, False);
+				olc_Image->data = nullptr;
+				XDestroyImage(olc_Image);
+				shmdt(olc_ShmInfo.shmaddr);
+			}
+			else
+				XDestroyImage(olc_Image);
+			olc_Image = nullptr;
+			XFreeGC(olc_Display, olc_GC);
+		}
+#endif
+	}
+
+	void PixelGameEngine::olc_OpenGLDestroy()
+	{
+		olc_PresentDestroy();
+
 #ifdef _WIN32
+		wglMakeCurrent(NULL, NULL);
 		wglDeleteContext(glRenderContext);
-		PostMessage(olc_hWnd, WM_DESTROY, 0, 0);
 #else
 		glXMakeCurrent(olc_Display, None, NULL);
 		glXDestroyContext(olc_Display, glDeviceContext);
-		XDestroyWindow(olc_Display, olc_Window);
-		XCloseDisplay(olc_Display);
 #endif
+	}
 
+	void PixelGameEngine::olc_PresentDestroy()
+	{
+		if (bGLStreaming) olc_glDeleteBuffers(2, glPixelBuffers);
+		if (glScreenProgram) olc_glDeleteProgram(glScreenProgram);
+		if (glScreenVertexArray) olc_glDeleteVertexArrays(1, &glScreenVertexArray);
+		glDeleteTextures(1, &glBuffer);
+		glScreenProgram = 0;
+		glScreenVertexArray = 0;
 	}
 
 #ifdef _WIN32 
@@ -2018,6 +3616,16 @@ namespace olc
 				if (++py == 48) { px++; py = 0; }
 			}
 		}
+
+		// DrawString works from the glyphs as bit rows
+		for (int g = 0; g < 96; g++)
+			for (int j = 0; j < 8; j++)
+			{
+				nFontGlyphs[g][j] = 0;
+				for (int i = 0; i < 8; i++)
+					if (fontSprite->GetPixel((g % 16) * 8 + i, (g / 16) * 8 + j).r > 0)
+						nFontGlyphs[g][j] |= 1 << i;
+			}
 	}
 
 #ifdef _WIN32
@@ -2117,22 +3725,46 @@ namespace olc
 
 	bool PixelGameEngine::olc_OpenGLCreate()
 	{
-		// Create Device Context
-		glDeviceContext = GetDC(olc_hWnd);
-		PIXELFORMATDESCRIPTOR pfd =
+		// Create Device Context, the window class owns it so a context made
+		// again after a failed core profile gets the same one back
+		if (glDeviceContext == nullptr) glDeviceContext = GetDC(olc_hWnd);
+
+		// A window takes a pixel format only once, the legacy fallback
+		// keeps the one that is already set
+		if (GetPixelFormat(glDeviceContext) == 0)
 		{
-			sizeof(PIXELFORMATDESCRIPTOR), 1,
-			PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
-			PFD_TYPE_RGBA, 32, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-			PFD_MAIN_PLANE, 0, 0, 0, 0
-		};
+			PIXELFORMATDESCRIPTOR pfd =
+			{
+				sizeof(PIXELFORMATDESCRIPTOR), 1,
+				PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
+				PFD_TYPE_RGBA, 32, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				PFD_MAIN_PLANE, 0, 0, 0, 0
+			};
 
-		int pf = 0;
-		if (!(pf = ChoosePixelFormat(glDeviceContext, &pfd))) return false;
-		SetPixelFormat(glDeviceContext, pf, &pfd);
+			int pf = 0;
+			if (!(pf = ChoosePixelFormat(glDeviceContext, &pfd))) return false;
+			if (!SetPixelFormat(glDeviceContext, pf, &pfd)) return false;
+		}
 
 		if (!(glRenderContext = wglCreateContext(glDeviceContext))) return false;
 		wglMakeCurrent(glDeviceContext, glRenderContext);
+		bGLCoreProfile = false;
+
+		// Swap the legacy context for a 3.3 core profile one if the driver
+		// offers it, otherwise keep the legacy context
+		wglCreateContextAttribsARB_t *wglCreateContextAttribsARB = (wglCreateContextAttribsARB_t*)wglGetProcAddress("wglCreateContextAttribsARB");
+		if (wglCreateContextAttribsARB && !bGLLegacyOnly)
+		{
+			int attribs[] = { WGL_CONTEXT_MAJOR_VERSION_ARB, 3, WGL_CONTEXT_MINOR_VERSION_ARB, 3, WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB, 0 };
+			HGLRC glCoreContext = wglCreateContextAttribsARB(glDeviceContext, nullptr, attribs);
+			if (glCoreContext)
+			{
+				wglMakeCurrent(glDeviceContext, glCoreContext);
+				wglDeleteContext(glRenderContext);
+				glRenderContext = glCoreContext;
+				bGLCoreProfile = true;
+			}
+		}
 
 		glViewport(nViewX, nViewY, nViewW, nViewH);
 
@@ -2195,8 +3827,23 @@ namespace olc
 		olc_WindowRoot	= DefaultRootWindow(olc_Display);
 
 		// Based on the display capabilities, configure the appearance of the window
-		GLint olc_GLAttribs[] = { GLX_RGBA, GLX_DEPTH_SIZE, 24, GLX_DOUBLEBUFFER, None };
-		olc_VisualInfo	= glXChooseVisual(olc_Display, 0, olc_GLAttribs);
+		unsigned long nAttribMask = CWColormap | CWEventMask;
+		if (nBackend == OPENGL)
+		{
+			GLint olc_GLAttribs[] = { GLX_RGBA, GLX_DEPTH_SIZE, 24, GLX_DOUBLEBUFFER, None };
+			olc_VisualInfo	= glXChooseVisual(olc_Display, 0, olc_GLAttribs);
+		}
+		else
+		{
+			// Without OpenGL the default visual is the one images are converted to,
+			// and the server paints the window background around the image
+			XVisualInfo vTemplate;
+			int nVisuals = 0;
+			vTemplate.visualid = XVisualIDFromVisual(DefaultVisual(olc_Display, DefaultScreen(olc_Display)));
+			olc_VisualInfo	= XGetVisualInfo(olc_Display, VisualIDMask, &vTemplate, &nVisuals);
+			olc_SetWindowAttribs.background_pixel = BlackPixel(olc_Display, DefaultScreen(olc_Display));
+			nAttribMask |= CWBackPixel;
+		}
 		olc_ColourMap	= XCreateColormap(olc_Display, olc_WindowRoot, olc_VisualInfo->visual, AllocNone);
 		olc_SetWindowAttribs.colormap = olc_ColourMap;
 
@@ -2204,7 +3851,7 @@ namespace olc
 		olc_SetWindowAttribs.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask | FocusChangeMask | StructureNotifyMask;
 
 		// Create the window
-		olc_Window		= XCreateWindow(olc_Display, olc_WindowRoot, 30, 30, nScreenWidth * nPixelWidth, nScreenHeight * nPixelHeight, 0, olc_VisualInfo->depth, InputOutput, olc_VisualInfo->visual, CWColormap | CWEventMask, &olc_SetWindowAttribs);
+		olc_Window		= XCreateWindow(olc_Display, olc_WindowRoot, 30, 30, nScreenWidth * nPixelWidth, nScreenHeight * nPixelHeight, 0, olc_VisualInfo->depth, InputOutput, olc_VisualInfo->visual, nAttribMask, &olc_SetWindowAttribs);
 
 		Atom wmDelete = XInternAtom(olc_Display, "WM_DELETE_WINDOW", true);
 		XSetWMProtocols(olc_Display, olc_Window, &wmDelete, 1);
@@ -2272,7 +3919,35 @@ namespace olc
 
 	bool PixelGameEngine::olc_OpenGLCreate()
 	{
-		glDeviceContext = glXCreateContext(olc_Display, olc_VisualInfo, nullptr, GL_TRUE);
+		// Prefer a 3.3 core profile context, which needs the framebuffer config
+		// belonging to the visual the window was created with
+		glXCreateContextAttribsARB_t *glXCreateContextAttribsARB = (glXCreateContextAttribsARB_t*)glXGetProcAddress((unsigned char*)"glXCreateContextAttribsARB");
+		glDeviceContext = nullptr;
+		if (glXCreateContextAttribsARB && !bGLLegacyOnly)
+		{
+			int nConfigs = 0;
+			GLXFBConfig *pConfigs = glXGetFBConfigs(olc_Display, DefaultScreen(olc_Display), &nConfigs);
+			for (int i = 0; i < nConfigs && glDeviceContext == nullptr; i++)
+			{
+				int nVisualID = 0;
+				glXGetFBConfigAttrib(olc_Display, pConfigs[i], GLX_VISUAL_ID, &nVisualID);
+				if ((VisualID)nVisualID != olc_VisualInfo->visualid) continue;
+
+				// A refused context is reported as an X error, which
+				// would otherwise terminate the program
+				int attribs[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 3, GLX_CONTEXT_MINOR_VERSION_ARB, 3, GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB, None };
+				auto oldHandler = XSetErrorHandler([](Display*, XErrorEvent*) { return 0; });
+				glDeviceContext = glXCreateContextAttribsARB(olc_Display, pConfigs[i], nullptr, True, attribs);
+				XSync(olc_Display, False);
+				XSetErrorHandler(oldHandler);
+			}
+			if (pConfigs) XFree(pConfigs);
+		}
+
+		bGLCoreProfile = glDeviceContext != nullptr;
+		if (!bGLCoreProfile)
+			glDeviceContext = glXCreateContext(olc_Display, olc_VisualInfo, nullptr, GL_TRUE);
+		if (!glDeviceContext) return false;
 		glXMakeCurrent(olc_Display, olc_Window, glDeviceContext);
 		
 		XWindowAttributes gwa;